@@ -0,0 +1,175 @@
+// Benchmark + correctness check for frustum culling.
+//
+// Culls a field of cubes against the demo's camera the way the render loop
+// does: each worker chunk tests its bounding spheres and compacts the
+// survivors into its own stretch of the index list. The camera turns a
+// little every frame so the visible set keeps changing. Reports spheres
+// tested per second and per core at 1, 2, 4, ... threads, and checks the
+// last frame's lists against a double-precision plane test: every cube
+// clearly inside must be listed, every cube clearly outside must not be.
+// Exits non-zero on a mismatch.
+//
+//   bench_cull [--count N] [--frames F] [--threads T]
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cubes.h"
+#include "cull.h"
+#include "workers.h"
+
+#define CHUNK 4096         // Instances per worker chunk, as in the demo
+#define RADIUS 0.8660254f  // Bounding sphere of the unit cube
+#define BOUNDARY 1e-3      // Spheres this near a plane may go either way
+
+typedef struct {
+  const CubeField* field;
+  Frustum frustum;
+  uint32_t* visible;  // Chunk c's survivors start at visible[c * CHUNK]
+  int* found;         // Per chunk
+} Job;
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void cull_job(void* ctx, int begin, int end) {
+  Job* job = (Job*)ctx;
+  const CubeField* f = job->field;
+  job->found[begin / CHUNK] =
+      cull_spheres(&job->frustum, f->x, f->y, f->z, RADIUS, begin, end,
+                   job->visible + begin);
+}
+
+// The demo's camera (45 degree lens, 16:9, 0.1 to 100, pulled back 3),
+// turned `yaw` degrees about y: column-major projection * view
+static void camera(float yaw, float out[16]) {
+  double f = 1.0 / tan(45.0 * M_PI / 360.0);
+  double n = 0.1, far = 100.0;
+  double p[16] = {0};
+  p[0] = f / (1280.0 / 720.0);
+  p[5] = f;
+  p[10] = (far + n) / (n - far);
+  p[11] = -1.0;
+  p[14] = 2.0 * far * n / (n - far);
+  double a = yaw * M_PI / 180.0, c = cos(a), s = sin(a);
+  double v[16] = {c, 0, -s, 0, 0, 1, 0, 0, s, 0, c, 0, 0, 0, -3, 1};
+  for (int col = 0; col < 4; col++) {
+    for (int row = 0; row < 4; row++) {
+      double sum = 0.0;
+      for (int k = 0; k < 4; k++) sum += p[4 * k + row] * v[4 * col + k];
+      out[4 * col + row] = (float)sum;
+    }
+  }
+}
+
+// Signed distance of sphere i from the frustum: the worst plane, in double
+static double reference(const Frustum* fr, const CubeField* f, int i) {
+  double worst = INFINITY;
+  for (int p = 0; p < 6; p++) {
+    double d = (double)f->x[i] * fr->nx[p] + (double)f->y[i] * fr->ny[p] +
+               (double)f->z[i] * fr->nz[p] + fr->d[p] + RADIUS;
+    if (d < worst) worst = d;
+  }
+  return worst;
+}
+
+// Number of cubes that disagree with the reference (near-boundary excused)
+static int check(const Job* job, int count) {
+  int bad = 0;
+  int chunks = (count + CHUNK - 1) / CHUNK;
+  for (int c = 0; c < chunks; c++) {
+    int begin = c * CHUNK;
+    int end = begin + CHUNK < count ? begin + CHUNK : count;
+    const uint32_t* list = job->visible + begin;
+    int k = 0;
+    for (int i = begin; i < end; i++) {
+      bool listed = k < job->found[c] && list[k] == (uint32_t)i;
+      if (listed) k++;
+      double d = reference(&job->frustum, job->field, i);
+      if (fabs(d) > BOUNDARY && listed != (d > 0.0)) bad++;
+    }
+    if (k != job->found[c]) bad++;  // Out of order or out of range
+  }
+  return bad;
+}
+
+int main(int argc, char** argv) {
+  int count = 1000000;
+  int frames = 100;
+  int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--count") == 0 && a + 1 < argc) {
+      count = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--frames") == 0 && a + 1 < argc) {
+      frames = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+      max_threads = atoi(argv[++a]);
+    } else {
+      printf("usage: %s [--count N] [--frames F] [--threads T]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (max_threads < 1) max_threads = 1;
+  if (max_threads > WORKERS_MAX) max_threads = WORKERS_MAX;
+  if (frames < 1) frames = 1;
+
+  static CubeField field;
+  uint32_t* visible = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)count);
+  int* found = (int*)calloc((size_t)(count + CHUNK - 1) / CHUNK, sizeof(int));
+  if (!cubes_init(&field, count) || !visible || !found) {
+    printf("Failed to allocate %d instances\n", count);
+    return 1;
+  }
+
+  printf("%d instances, %d frames, %d-wide groups\n", count, frames,
+         TRANSFORM_LANES);
+  printf("%7s %12s %14s %12s %10s\n", "threads", "ms/frame", "Mspheres/s",
+         "per core", "visible");
+
+  int failures = 0;
+  int chunks = (count + CHUNK - 1) / CHUNK;
+  for (int threads = 1;; threads *= 2) {
+    if (threads > max_threads) threads = max_threads;
+    WorkerPool pool;
+    int got = workers_start(&pool, threads);
+    Job job = {.field = &field, .visible = visible, .found = found};
+
+    long long seen = 0;
+    double start = now_sec();
+    for (int f = 0; f < frames; f++) {
+      float pv[16];
+      camera(f * 3.6f, pv);
+      cull_planes(&job.frustum, pv);
+      workers_run(&pool, count, CHUNK, cull_job, &job);
+      for (int c = 0; c < chunks; c++) seen += found[c];
+    }
+    double wall = now_sec() - start;
+    int bad = check(&job, count);
+    workers_stop(&pool);
+
+    double rate = (double)count * frames / wall;
+    printf("%7d %12.3f %14.1f %12.1f %10lld  %d mismatched %s\n", got,
+           wall * 1e3 / frames, rate / 1e6, rate / 1e6 / got, seen / frames,
+           bad, bad ? "MISMATCH" : "ok");
+    if (bad) failures++;
+    if (threads == max_threads) break;
+  }
+
+  free(visible);
+  free(found);
+  cubes_free(&field);
+  if (failures) {
+    printf("%d run(s) disagree with the reference\n", failures);
+    return 1;
+  }
+  return 0;
+}
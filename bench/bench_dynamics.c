@@ -0,0 +1,199 @@
+// Benchmark + correctness check for the master dynamics.
+//
+// Times dynamics_process on a loud mix of overlapping bursts, then checks
+// the limiter three ways: the sliding-window minimum against a brute-force
+// minimum over the last DYN_LOOKAHEAD samples, for random gains; bursts far
+// above the ceiling through the whole limiter, which must hold them under
+// the ceiling on its own (the output guard clamp may trim float rounding,
+// but never a real overshoot); and silence after a limited burst, which
+// must bring both gain stages back to rest so silent blocks skip the DSP
+// again. Exits non-zero on a mismatch.
+//
+//   bench_dynamics [--seconds S]
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dynamics.h"
+
+#define RATE 48000.0
+#define BLOCK 512
+#define DELAY (DYN_LOOKAHEAD - 1)  // dynamics_latency()
+#define ROUNDING 1e-5f  // Relative overshoot the guard clamp is there for
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// xorshift32, uniform in [0, 1)
+static float rnd(uint32_t* s) {
+  *s ^= *s << 13;
+  *s ^= *s >> 17;
+  *s ^= *s << 5;
+  return (float)(*s >> 8) * (1.0f / 16777216.0f);
+}
+
+// Bursts every `spacing` samples, each starting `over` times above full
+// scale and decaying over a few hundred samples. Random signs; with `noise`
+// random magnitudes under the envelope too, otherwise the envelope itself,
+// whose falling peak needs a rising gain sample after sample (the longest
+// the limiter's deque ever gets).
+static void bursts(float* x, int n, float over, int spacing, bool noise,
+                   uint32_t* s) {
+  for (int i = 0; i < n; i++) {
+    int k = i % spacing;
+    float env = over * expf(-(float)k / 400.0f);
+    x[i] = noise ? env * (2.0f * rnd(s) - 1.0f)
+                 : rnd(s) < 0.5f ? env : -env;
+  }
+}
+
+// Required gains alternating between random stretches, many at 1 (nothing
+// to limit), and rising ramps longer than the window
+static int check_window(int samples) {
+  static Dynamics d;
+  dynamics_init(&d, RATE);
+  float* r = (float*)malloc(sizeof(float) * (size_t)samples);
+  if (!r) return 1;
+  uint32_t s = 12345;
+  int bad = 0;
+  for (int t = 0; t < samples; t++) {
+    int k = t % 400;
+    if (k < 200) {
+      r[t] = rnd(&s) < 0.3f ? 1.0f : 0.05f + 0.95f * rnd(&s);
+    } else {
+      r[t] = 0.05f + 0.9f * (float)(k - 200) / 200.0f;
+    }
+    float got = dynamics_window_min(&d, r[t]);
+    float want = 1.0f;
+    for (int k = t - DYN_LOOKAHEAD + 1; k <= t; k++) {
+      if (k >= 0 && r[k] < want) want = r[k];
+    }
+    if (got != want) {
+      if (bad == 0) {
+        printf("  window min at t=%d: %g, want %g\n", t, got, want);
+      }
+      bad++;
+    }
+  }
+  free(r);
+  printf("window min    %8d samples  %6d wrong %s\n", samples, bad,
+         bad ? "MISMATCH" : "ok");
+  return bad;
+}
+
+// The compressor set to unity, so the limiter's input is the test signal
+// and its output before the guard clamp can be recomputed exactly
+static int check_ceiling(int samples, bool noise) {
+  static Dynamics d;
+  dynamics_init(&d, RATE);
+  d.ratio = 1.0f;
+  d.makeup_db = 0.0f;
+  d.comp_gain = 1.0f;
+  float* x = (float*)malloc(sizeof(float) * (size_t)samples);
+  if (!x) return 1;
+  uint32_t s = 777;
+  bursts(x, samples, 6.0f, 3000, noise, &s);
+
+  int caught = 0;
+  float buf[BLOCK];
+  for (int t0 = 0; t0 + BLOCK <= samples; t0 += BLOCK) {
+    memcpy(buf, x + t0, sizeof(buf));
+    dynamics_process(&d, buf, BLOCK, false);
+    for (int i = 0; i < BLOCK; i++) {
+      int t = t0 + i - DELAY;
+      float y = (t >= 0 ? x[t] : 0.0f) * d.gain[i];
+      if (fabsf(y) > d.ceiling * (1.0f + ROUNDING)) caught++;
+    }
+  }
+  free(x);
+  printf("ceiling %-5s %8d samples  %6d clamped %s\n",
+         noise ? "noise" : "peaks", samples, caught,
+         caught ? "MISMATCH" : "ok");
+  return caught;
+}
+
+// Loud, limited blocks with the default settings, then silence: the rest
+// state (the idle fast path) must come back within REST_SECONDS
+#define REST_SECONDS 10.0
+static int check_rest(void) {
+  static Dynamics d;
+  dynamics_init(&d, RATE);
+  static float x[BLOCK * 20];
+  uint32_t s = 4242;
+  bursts(x, BLOCK * 20, 6.0f, 3000, true, &s);
+  float buf[BLOCK];
+  for (int b = 0; b < 20; b++) {
+    memcpy(buf, x + b * BLOCK, sizeof(buf));
+    dynamics_process(&d, buf, BLOCK, false);
+  }
+  bool limited = d.min_gain < 0.5f;
+  int blocks = (int)(REST_SECONDS * RATE / BLOCK), rested = -1;
+  for (int b = 0; b < blocks && rested < 0; b++) {
+    memset(buf, 0, sizeof(buf));
+    dynamics_process(&d, buf, BLOCK, true);
+    if (dynamics_at_rest(&d)) rested = b + 1;
+  }
+  int bad = !limited || rested < 0;
+  if (rested < 0) {
+    printf("rest          never within %.0f s (held %.6f, %d below 1) "
+           "MISMATCH\n",
+           REST_SECONDS, d.held, d.box_low);
+  } else {
+    // The idle path, now it's taken
+    int idle = 100000;
+    double start = now_sec();
+    for (int b = 0; b < idle; b++) dynamics_process(&d, buf, BLOCK, true);
+    double wall = now_sec() - start;
+    printf("rest          %8.2f s of silence  %6.2f ns/sample idle %s\n",
+           rested * BLOCK / RATE, wall * 1e9 / ((double)idle * BLOCK),
+           bad ? "MISMATCH" : "ok");
+  }
+  return bad;
+}
+
+int main(int argc, char** argv) {
+  double seconds = 10.0;
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) {
+      seconds = atof(argv[++a]);
+    } else {
+      printf("usage: %s [--seconds S]\n", argv[0]);
+      return 2;
+    }
+  }
+  int blocks = (int)(seconds * RATE / BLOCK);
+  if (blocks < 1) blocks = 1;
+
+  static Dynamics d;
+  dynamics_init(&d, RATE);
+  static float mix[BLOCK * 64];
+  uint32_t s = 99;
+  bursts(mix, BLOCK * 64, 3.0f, 1100, true, &s);
+  float buf[BLOCK];
+  double start = now_sec();
+  for (int b = 0; b < blocks; b++) {
+    memcpy(buf, mix + (b % 64) * BLOCK, sizeof(buf));
+    dynamics_process(&d, buf, BLOCK, false);
+  }
+  double wall = now_sec() - start;
+  printf("%d blocks of %d at %.0f Hz\n", blocks, BLOCK, RATE);
+  printf("limiting      %8.2f ns/sample  %8.1fx real time\n",
+         wall * 1e9 / ((double)blocks * BLOCK),
+         (double)blocks * BLOCK / RATE / wall);
+
+  int bad = check_window(100000) + check_ceiling((int)(20.0 * RATE), false) +
+            check_ceiling((int)(20.0 * RATE), true) + check_rest();
+  if (bad) {
+    printf("The limiter disagrees with the reference\n");
+    return 1;
+  }
+  return 0;
+}
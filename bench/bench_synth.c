@@ -0,0 +1,421 @@
+// Offline benchmark + golden-output check for the synthesis kernel.
+//
+// Drives the voices exactly the way AQCallback does (1024-sample blocks)
+// from fixed, seeded note sequences, so no audio device is needed. Reports
+// ns/sample, real-time factor and how many voices one core could sustain,
+// then hashes the rendered PCM and compares it with the golden file so an
+// optimization can't silently change the sound.
+//
+//   bench_synth [--seconds S] [--golden FILE] [--update-golden]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "additive.h"
+#include "granular.h"
+#include "params.h"
+#include "pluck.h"
+#include "synth.h"
+
+#ifndef BENCH_GOLDEN_FILE
+#define BENCH_GOLDEN_FILE "bench/synth_golden.txt"
+#endif
+
+#define BLOCK 1024
+#define MAX_VOICES 64
+
+typedef enum { KIND_FM, KIND_FM_AUTO, KIND_PLUCK, KIND_GRAIN, KIND_ADD } Kind;
+
+typedef struct {
+  const char* name;
+  Kind kind;
+  int voices;
+  uint32_t seed;
+} Scenario;
+
+static const Scenario kScenarios[] = {
+    {"fm_1voice", KIND_FM, 1, 0x5EED0001u},
+    {"fm_16voices", KIND_FM, 16, 0x5EED0010u},
+    {"fm_automate", KIND_FM_AUTO, 16, 0x5EED0A70u},
+    {"ks_64strings", KIND_PLUCK, PLUCK_MAX_STRINGS, 0x5EED0040u},
+    {"gran_4000", KIND_GRAIN, 4000, 0x5EED0FA0u},
+    {"add_8x256", KIND_ADD, ADD_MAX_VOICES * ADD_MAX_PARTIALS, 0x5EED0800u},
+};
+#define NUM_SCENARIOS (int)(sizeof(kScenarios) / sizeof(kScenarios[0]))
+
+// FNV-1a over the little-endian bytes of each sample
+static uint64_t fnv1a(uint64_t h, const int16_t* pcm, int n) {
+  for (int i = 0; i < n; i++) {
+    uint16_t v = (uint16_t)pcm[i];
+    h = (h ^ (v & 0xFF)) * 0x100000001B3ull;
+    h = (h ^ (v >> 8)) * 0x100000001B3ull;
+  }
+  return h;
+}
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+  uint64_t hash;
+  double wall;
+  long long samples;  // Summed over all voices
+} Result;
+
+// Each voice plays its own seeded copy of the render loop's sequencer.
+static Result run_fm(const Scenario* sc, double seconds) {
+  AudioState voices[MAX_VOICES];
+  SynthSeq seqs[MAX_VOICES];
+  static int16_t out[BLOCK];
+
+  for (int v = 0; v < sc->voices; v++) {
+    synth_init(&voices[v], SYNTH_SAMPLE_RATE);
+    synth_seq_init(&seqs[v], sc->seed + (uint32_t)v * 0x9E3779B9u);
+  }
+
+  const int tick_len = SYNTH_TICK_SAMPLES;
+  long long total = (long long)(seconds * SYNTH_SAMPLE_RATE);
+  Result r = {0xCBF29CE484222325ull, 0.0, 0};
+
+  double t0 = now_sec();
+  for (long long pos = 0; pos < total;) {
+    // Split blocks at tick boundaries, as the hashes were recorded that way
+    int n = BLOCK;
+    long long next_tick = (pos / tick_len + 1) * tick_len;
+    if (pos + n > next_tick) n = (int)(next_tick - pos);
+    if (pos + n > total) n = (int)(total - pos);
+
+    for (int v = 0; v < sc->voices; v++) {
+      synth_seq_render(&voices[v], &seqs[v], out, n);
+      r.hash = fnv1a(r.hash, out, n);
+    }
+    pos += n;
+  }
+  r.wall = now_sec() - t0;
+  r.samples = total * sc->voices;
+  return r;
+}
+
+static uint32_t xorshift(uint32_t* s) {
+  *s ^= *s << 13;
+  *s ^= *s >> 17;
+  *s ^= *s << 5;
+  return *s;
+}
+
+static float rand_unit(uint32_t* s) {
+  return (float)(xorshift(s) >> 8) / 16777216.0f;
+}
+
+// fm_16voices with every voice's volume, index and ratio automated, padded
+// out to PARAM_MAX parameters. All targets are rewritten before every block
+// and a lane event lands mid-tick, so comparing ns/sample with fm_16voices
+// shows what automation costs the callback.
+static Result run_fm_auto(const Scenario* sc, double seconds) {
+  static ParamBank pb;
+  static int16_t out[MAX_VOICES][BLOCK];
+  AudioState voices[MAX_VOICES];
+  SynthSeq seqs[MAX_VOICES];
+  int ids[MAX_VOICES][3];
+  uint32_t rng = sc->seed;
+
+  params_init(&pb, SYNTH_SAMPLE_RATE);
+  for (int v = 0; v < sc->voices; v++) {
+    synth_init(&voices[v], SYNTH_SAMPLE_RATE);
+    synth_seq_init(&seqs[v], sc->seed + (uint32_t)v * 0x9E3779B9u);
+    ids[v][0] = params_add(&pb, 0.5f, 0.0f, 1.0f, PARAM_LINEAR, 0.02);
+    ids[v][1] = params_add(&pb, 3.0f, 0.0f, 10.0f, PARAM_EXP, 0.05);
+    ids[v][2] = params_add(&pb, 2.0f, 0.5f, 8.0f, PARAM_EXP, 0.05);
+  }
+  for (int id = pb.count; id < PARAM_MAX; id++) {
+    params_add(&pb, 0.0f, 0.0f, 1.0f, PARAM_LINEAR, 0.01);
+  }
+
+  const int tick_len = SYNTH_TICK_SAMPLES;
+  long long total = (long long)(seconds * SYNTH_SAMPLE_RATE);
+  Result r = {0xCBF29CE484222325ull, 0.0, 0};
+
+  double t0 = now_sec();
+  for (long long pos = 0; pos < total;) {
+    if (pos % tick_len == 0) {
+      int v = (int)(xorshift(&rng) % (uint32_t)sc->voices);
+      params_schedule(&pb, ids[v][2], pos + tick_len / 2,
+                      1.0f + (float)(xorshift(&rng) % 4), -1.0f);
+    }
+    // The control thread's view: every target changes every block
+    for (int v = 0; v < sc->voices; v++) {
+      params_set(&pb, ids[v][0], 0.3f + 0.3f * rand_unit(&rng));
+      params_set(&pb, ids[v][1], 1.0f + 4.0f * rand_unit(&rng));
+    }
+    for (int id = sc->voices * 3; id < PARAM_MAX; id++) {
+      params_set(&pb, id, rand_unit(&rng));
+    }
+
+    int n = BLOCK;
+    long long next_tick = (pos / tick_len + 1) * tick_len;
+    if (pos + n > next_tick) n = (int)(next_tick - pos);
+    if (pos + n > total) n = (int)(total - pos);
+    n = params_until_event(&pb, n);
+
+    params_begin(&pb);
+    for (int s = 0; s < n; s += PARAM_SLICE) {
+      int m = n - s < PARAM_SLICE ? n - s : PARAM_SLICE;
+      for (int v = 0; v < sc->voices; v++) {
+        voices[v].vol = params_get(&pb, ids[v][0]);
+        voices[v].mod_index = params_get(&pb, ids[v][1]);
+        voices[v].mod_ratio = params_get(&pb, ids[v][2]);
+        synth_seq_render(&voices[v], &seqs[v], out[v] + s, m);
+      }
+      params_advance(&pb, m);
+    }
+    for (int v = 0; v < sc->voices; v++) r.hash = fnv1a(r.hash, out[v], n);
+    pos += n;
+  }
+  r.wall = now_sec() - t0;
+  r.samples = total * sc->voices;
+  return r;
+}
+
+// Every string rings at once: all of them are plucked up front with a long
+// sustain, then one random string is re-plucked (or struck) on each tick.
+static Result run_pluck(const Scenario* sc, double seconds) {
+  static PluckBank pb;
+  static int16_t out[BLOCK];
+  uint32_t rng = sc->seed;
+
+  pluck_init(&pb, SYNTH_SAMPLE_RATE);
+  for (int v = 0; v < sc->voices; v++) {
+    int k = (int)(xorshift(&rng) % 15);
+    pluck_trigger(&pb, synth_bass_note(k) * (1 << (v % 4)), 0.5, 0.5, 8.0,
+                  PLUCK_PLUCKED);
+  }
+
+  const int tick_len = SYNTH_TICK_SAMPLES;
+  long long total = (long long)(seconds * SYNTH_SAMPLE_RATE);
+  Result r = {0xCBF29CE484222325ull, 0.0, 0};
+
+  double t0 = now_sec();
+  for (long long pos = 0; pos < total;) {
+    int n = BLOCK;
+    long long next_tick = (pos / tick_len + 1) * tick_len;
+    if (pos > 0 && pos % tick_len == 0) {
+      uint32_t x = xorshift(&rng);
+      double freq = synth_bass_note((int)(x % 15)) * (1 << ((x >> 8) % 4));
+      pluck_trigger(&pb, freq, 0.5, 0.5, 8.0,
+                    (x >> 16) % 4 == 0 ? PLUCK_STRUCK : PLUCK_PLUCKED);
+    }
+    if (pos + n > next_tick) n = (int)(next_tick - pos);
+    if (pos + n > total) n = (int)(total - pos);
+
+    memset(out, 0, sizeof(int16_t) * (size_t)n);
+    pluck_mix(&pb, out, n);
+    r.hash = fnv1a(r.hash, out, n);
+    pos += n;
+  }
+  r.wall = now_sec() - t0;
+  r.samples = total * sc->voices;
+  return r;
+}
+
+// Granular cloud over 5 s of rendered bass: 100 ms grains at a density
+// that keeps sc->voices of them alive at once.
+static Result run_grain(const Scenario* sc, double seconds) {
+  static GranularEngine ge;
+  static int16_t out[BLOCK];
+  static int16_t pcm[5 * (int)SYNTH_SAMPLE_RATE];
+  static float src[5 * (int)SYNTH_SAMPLE_RATE];
+  const int src_len = (int)(5 * SYNTH_SAMPLE_RATE);
+
+  AudioState as;
+  SynthSeq seq;
+  synth_init(&as, SYNTH_SAMPLE_RATE);
+  synth_seq_init(&seq, sc->seed);
+  synth_seq_render(&as, &seq, pcm, src_len);
+  for (int i = 0; i < src_len; i++) src[i] = pcm[i] / 32768.0f;
+
+  granular_init(&ge, SYNTH_SAMPLE_RATE, sc->seed);
+  granular_set_source(&ge, src, (size_t)src_len);
+  GranularParams p = {
+      .density = sc->voices / 0.1,
+      .duration_sec = 0.1,
+      .position = 0.5,
+      .position_jitter = 0.5,
+      .rate = 1.0,
+      .rate_jitter = 0.5,
+      .amp = 0.5f / sc->voices,
+      .window = GRAIN_WIN_HANN,
+  };
+  granular_set_params(&ge, &p);
+
+  long long total = (long long)(seconds * SYNTH_SAMPLE_RATE);
+  Result r = {0xCBF29CE484222325ull, 0.0, 0};
+
+  double t0 = now_sec();
+  for (long long pos = 0; pos < total; pos += BLOCK) {
+    int n = total - pos < BLOCK ? (int)(total - pos) : BLOCK;
+    memset(out, 0, sizeof(int16_t) * (size_t)n);
+    granular_mix(&ge, out, n);
+    r.hash = fnv1a(r.hash, out, n);
+  }
+  r.wall = now_sec() - t0;
+  r.samples = total * sc->voices;
+  return r;
+}
+
+// Every additive voice holds a low note (so all partials are below Nyquist)
+// and gets a fresh random amplitude table on every tick, as the render loop
+// would publish them at control rate.
+static Result run_additive(const Scenario* sc, double seconds) {
+  static AdditiveBank ab;
+  static int16_t out[BLOCK];
+  static float amps[ADD_MAX_PARTIALS];
+  uint32_t rng = sc->seed;
+
+  additive_init(&ab, SYNTH_SAMPLE_RATE);
+  for (int v = 0; v < ADD_MAX_VOICES; v++) {
+    additive_note_on(&ab, v, synth_bass_note(v % 5), 0.1f, 0.01);
+  }
+
+  const int tick_len = SYNTH_TICK_SAMPLES;
+  long long total = (long long)(seconds * SYNTH_SAMPLE_RATE);
+  Result r = {0xCBF29CE484222325ull, 0.0, 0};
+
+  double t0 = now_sec();
+  for (long long pos = 0; pos < total;) {
+    int n = BLOCK;
+    long long next_tick = (pos / tick_len + 1) * tick_len;
+    if (pos % tick_len == 0) {
+      int v = (int)(xorshift(&rng) % ADD_MAX_VOICES);
+      for (int k = 0; k < ADD_MAX_PARTIALS; k++) {
+        amps[k] = (float)(xorshift(&rng) >> 8) / 16777216.0f / (k + 1);
+      }
+      additive_set_amps(&ab, v, amps, ADD_MAX_PARTIALS);
+    }
+    if (pos + n > next_tick) n = (int)(next_tick - pos);
+    if (pos + n > total) n = (int)(total - pos);
+
+    memset(out, 0, sizeof(int16_t) * (size_t)n);
+    additive_mix(&ab, out, n);
+    r.hash = fnv1a(r.hash, out, n);
+    pos += n;
+  }
+  r.wall = now_sec() - t0;
+  r.samples = total * sc->voices;
+  return r;
+}
+
+static Result run_scenario(const Scenario* sc, double seconds) {
+  switch (sc->kind) {
+    case KIND_ADD:
+      return run_additive(sc, seconds);
+    case KIND_FM_AUTO:
+      return run_fm_auto(sc, seconds);
+    case KIND_PLUCK:
+      return run_pluck(sc, seconds);
+    case KIND_GRAIN:
+      return run_grain(sc, seconds);
+    default:
+      return run_fm(sc, seconds);
+  }
+}
+
+// Golden file: one "<scenario> <seconds> <hash>" line per scenario.
+static int golden_lookup(const char* path, const char* name, double seconds,
+                         uint64_t* hash) {
+  FILE* f = fopen(path, "r");
+  if (!f) return 0;
+  char line[256], key[64];
+  double secs;
+  unsigned long long h;
+  int found = 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%63s %lf %llx", key, &secs, &h) == 3 &&
+        strcmp(key, name) == 0 && secs == seconds) {
+      *hash = (uint64_t)h;
+      found = 1;
+    }
+  }
+  fclose(f);
+  return found;
+}
+
+int main(int argc, char** argv) {
+  double seconds = 60.0;
+  const char* golden = BENCH_GOLDEN_FILE;
+  int update = 0;
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) {
+      seconds = atof(argv[++a]);
+    } else if (strcmp(argv[a], "--golden") == 0 && a + 1 < argc) {
+      golden = argv[++a];
+    } else if (strcmp(argv[a], "--update-golden") == 0) {
+      update = 1;
+    } else {
+      printf("usage: %s [--seconds S] [--golden FILE] [--update-golden]\n",
+             argv[0]);
+      return 2;
+    }
+  }
+
+  FILE* gf = NULL;
+  if (update) {
+    gf = fopen(golden, "w");
+    if (!gf) {
+      printf("Failed to open %s for writing\n", golden);
+      return 1;
+    }
+    fprintf(gf,
+            "# Golden hashes for bench_synth: <scenario> <seconds> <fnv1a64>\n"
+            "# Regenerate with --update-golden only for intended changes.\n"
+            "# Hashes depend on libm's sin/exp, so they are per-platform.\n");
+  }
+
+  int failures = 0;
+  printf("%-12s %7s %10s %10s %12s  %s\n", "scenario", "voices", "ns/sample",
+         "RT factor", "voices/core", "hash");
+  for (int i = 0; i < NUM_SCENARIOS; i++) {
+    const Scenario* sc = &kScenarios[i];
+    Result r = run_scenario(sc, seconds);
+
+    double ns_per_sample = r.wall * 1e9 / (double)r.samples;
+    double rt_factor = seconds / r.wall;
+    // One real-time voice needs SYNTH_SAMPLE_RATE samples per second
+    double voices_per_core = 1e9 / (ns_per_sample * SYNTH_SAMPLE_RATE);
+
+    const char* status = "";
+    if (update) {
+      fprintf(gf, "%s %g %016llx\n", sc->name, seconds,
+              (unsigned long long)r.hash);
+      status = "(written)";
+    } else {
+      uint64_t expect;
+      if (!golden_lookup(golden, sc->name, seconds, &expect)) {
+        status = "MISSING GOLDEN";
+        failures++;
+      } else if (expect != r.hash) {
+        status = "MISMATCH";
+        failures++;
+      } else {
+        status = "ok";
+      }
+    }
+    printf("%-12s %7d %10.2f %10.1f %12.1f  %016llx %s\n", sc->name,
+           sc->voices, ns_per_sample, rt_factor, voices_per_core,
+           (unsigned long long)r.hash, status);
+  }
+
+  if (gf) fclose(gf);
+  if (failures) {
+    printf("%d scenario(s) differ from %s\n", failures, golden);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,182 @@
+// Benchmark + correctness check for the instance transform update.
+//
+// Spins a field of cubes and writes their model matrices the way the demo's
+// --anim simd mode does: first one matrix at a time, then TRANSFORM_LANES at
+// a time, then gathered through an index list (as for the visible cubes),
+// then split across worker threads. Reports matrices per second and
+// per core, and checks every path against a double-precision axis-angle
+// reference (the formula glm_rotate uses), so a faster kernel can't quietly
+// get the maths wrong. Exits non-zero on a mismatch.
+//
+//   bench_transforms [--count N] [--frames F] [--threads T]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cubes.h"
+#include "transforms.h"
+#include "workers.h"
+
+#define CHUNK 4096         // Instances per worker chunk, as in the demo
+#define MAX_ERROR 2e-5     // Per matrix element
+#define CHECK_STRIDE 997   // Instances sampled by the check
+
+typedef struct {
+  const CubeField* field;
+  TransformSet* set;
+  const uint32_t* index;  // Identity, for the gather kernel
+  float turn;
+  float* out;
+} Job;
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// The old way: a sin/cos per cube, then one matrix at a time
+static void scalar_job(void* ctx, int begin, int end) {
+  Job* job = (Job*)ctx;
+  const CubeField* f = job->field;
+  for (int i = begin; i < end; i++) {
+    float h = (f->phase[i] + job->turn) * (float)(M_PI / 360.0);
+    float s = sinf(h);
+    job->set->qx[i] = f->ax[i] * s;
+    job->set->qy[i] = f->ay[i] * s;
+    job->set->qz[i] = f->az[i] * s;
+    job->set->qw[i] = cosf(h);
+  }
+  transforms_write_scalar(job->set, begin, end, job->out);
+}
+
+static void lanes_job(void* ctx, int begin, int end) {
+  Job* job = (Job*)ctx;
+  cubes_spin(job->field, job->turn, begin, end, job->set);
+  transforms_write(job->set, begin, end, job->out);
+}
+
+static void list_job(void* ctx, int begin, int end) {
+  Job* job = (Job*)ctx;
+  cubes_spin(job->field, job->turn, begin, end, job->set);
+  transforms_write_list(job->set, job->index + begin, end - begin,
+                        job->out + 16 * (size_t)begin);
+}
+
+// Largest element error of instance i against
+// translate(centre) * rotate(phase + turn, axis)
+static double check_one(const CubeField* f, float turn, const float* out,
+                        int i) {
+  double a = (f->phase[i] + turn) * (M_PI / 180.0);
+  double c = cos(a), s = sin(a), t = 1.0 - c;
+  double x = f->ax[i], y = f->ay[i], z = f->az[i];
+  double ref[16] = {c + x * x * t,     y * x * t + z * s, z * x * t - y * s,
+                    0.0,               x * y * t - z * s, c + y * y * t,
+                    z * y * t + x * s, 0.0,               x * z * t + y * s,
+                    y * z * t - x * s, c + z * z * t,     0.0,
+                    f->x[i],           f->y[i],           f->z[i],
+                    1.0};
+  const float* m = out + 16 * (size_t)i;
+  double worst = 0.0;
+  for (int k = 0; k < 16; k++) worst = fmax(worst, fabs(m[k] - ref[k]));
+  return worst;
+}
+
+// Every CHECK_STRIDE-th instance, plus the last (which is in the scalar
+// tail when count isn't a multiple of the group size)
+static double check(const CubeField* f, float turn, const float* out) {
+  double worst = check_one(f, turn, out, f->count - 1);
+  for (int i = 0; i < f->count; i += CHECK_STRIDE) {
+    worst = fmax(worst, check_one(f, turn, out, i));
+  }
+  return worst;
+}
+
+int main(int argc, char** argv) {
+  int count = 1000000;
+  int frames = 40;
+  int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--count") == 0 && a + 1 < argc) {
+      count = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--frames") == 0 && a + 1 < argc) {
+      frames = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+      max_threads = atoi(argv[++a]);
+    } else {
+      printf("usage: %s [--count N] [--frames F] [--threads T]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (max_threads < 1) max_threads = 1;
+  if (max_threads > WORKERS_MAX) max_threads = WORKERS_MAX;
+  if (frames < 1) frames = 1;
+
+  static CubeField field;
+  static TransformSet set;
+  float* out = (float*)malloc(sizeof(float) * 16 * (size_t)count);
+  uint32_t* index = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)count);
+  if (!cubes_init(&field, count) || !transforms_init(&set, count) || !out ||
+      !index) {
+    printf("Failed to allocate %d instances\n", count);
+    return 1;
+  }
+  cubes_place(&field, &set);
+  for (int i = 0; i < count; i++) index[i] = (uint32_t)i;
+
+  printf("%d instances, %d frames, %d-wide groups\n", count, frames,
+         TRANSFORM_LANES);
+  printf("%-8s %7s %12s %14s %12s\n", "kernel", "threads", "ms/frame",
+         "Mmatrices/s", "per core");
+
+  int failures = 0;
+  for (int run = 0;; run++) {
+    // Run 0 is scalar and run 1 the gather kernel, 1 thread each; then
+    // lanes at 1, 2, 4, ... threads
+    bool scalar = run == 0;
+    bool list = run == 1;
+    int threads = scalar || list ? 1 : 1 << (run - 2);
+    if (threads > max_threads) {
+      if ((threads >> 1) >= max_threads) break;
+      threads = max_threads;  // Always finish on the full count
+    }
+
+    WorkerPool pool;
+    int got = workers_start(&pool, threads);
+    Job job = {&field, &set, index, 0.0f, out};
+    WorkerFn fn = scalar ? scalar_job : list ? list_job : lanes_job;
+
+    double start = now_sec();
+    for (int f = 0; f < frames; f++) {
+      job.turn = fmodf(25.0f * f / 60.0f, 360.0f);
+      workers_run(&pool, count, CHUNK, fn, &job);
+    }
+    double wall = now_sec() - start;
+    double worst = check(&field, job.turn, out);
+    workers_stop(&pool);
+
+    double rate = (double)count * frames / wall;
+    bool ok = worst <= MAX_ERROR;
+    const char* kernel = scalar ? "scalar" : list ? "list" : "lanes";
+    printf("%-8s %7d %12.3f %14.1f %12.1f  max err %.1e %s\n", kernel, got,
+           wall * 1e3 / frames, rate / 1e6, rate / 1e6 / got, worst,
+           ok ? "ok" : "MISMATCH");
+    if (!ok) failures++;
+    if (!scalar && !list && threads == max_threads) break;
+  }
+
+  free(out);
+  free(index);
+  transforms_free(&set);
+  cubes_free(&field);
+  if (failures) {
+    printf("%d kernel(s) disagree with the reference\n", failures);
+    return 1;
+  }
+  return 0;
+}
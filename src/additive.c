@@ -0,0 +1,176 @@
+#include "additive.h"
+
+#include <math.h>
+#include <string.h>
+
+void additive_init(AdditiveBank* ab, double sample_rate) {
+  memset(ab, 0, sizeof(*ab));
+  ab->sample_rate = sample_rate;
+
+  for (int v = 0; v < ADD_MAX_VOICES; v++) {
+    AdditiveVoice* voice = &ab->voices[v];
+    for (int k = 0; k < ADD_MAX_PARTIALS; k++) {
+      voice->ratio[k] = (float)(k + 1);
+      voice->re[k] = 1.0f;
+      voice->rot_re[k] = 1.0f;
+      float a = 0.2f / (float)(k + 1);
+      for (int b = 0; b < 3; b++) voice->targets.amps[b][k] = a;
+    }
+    voice->targets.back = 0;
+    voice->targets.front = 1;
+    atomic_init(&voice->targets.middle, 2u);
+  }
+}
+
+void additive_set_ratios(AdditiveBank* ab, int voice, const float* ratios,
+                         int count) {
+  AdditiveVoice* v = &ab->voices[voice];
+  for (int k = 0; k < ADD_MAX_PARTIALS; k++) {
+    v->ratio[k] = k < count ? ratios[k] : 1e9f;  // Unused: above Nyquist
+  }
+}
+
+void additive_note_on(AdditiveBank* ab, int voice, double freq, float level,
+                      double attack) {
+  AdditiveVoice* v = &ab->voices[voice];
+  double nyquist = 0.5 * ab->sample_rate;
+  int audible = 0;
+
+  // Retune the rotors but keep the phases, so a glide doesn't click
+  for (int k = 0; k < ADD_MAX_PARTIALS; k++) {
+    double f = freq * v->ratio[k];
+    if (f >= nyquist) break;  // Ratios ascend: everything after is too
+    double w = 2.0 * M_PI * f / ab->sample_rate;
+    v->rot_re[k] = (float)cos(w);
+    v->rot_im[k] = (float)sin(w);
+    audible = k + 1;
+  }
+  v->audible = (audible + ADD_LANES - 1) / ADD_LANES * ADD_LANES;
+  // Padding partials in the last group must stay silent
+  for (int k = audible; k < v->audible; k++) {
+    v->rot_re[k] = 1.0f;
+    v->rot_im[k] = 0.0f;
+    v->re[k] = 1.0f;
+    v->im[k] = 0.0f;
+  }
+
+  v->freq = freq;
+  v->level_target = level;
+  v->level_rate = (float)(1.0 / (attack * ab->sample_rate + 1.0));
+}
+
+void additive_note_off(AdditiveBank* ab, int voice, double release) {
+  AdditiveVoice* v = &ab->voices[voice];
+  v->level_target = 0.0f;
+  v->level_rate = (float)(1.0 / (release * ab->sample_rate + 1.0));
+}
+
+void additive_set_amps(AdditiveBank* ab, int voice, const float* amps,
+                       int count) {
+  AddAmpBuffer* t = &ab->voices[voice].targets;
+  float* dst = t->amps[t->back];
+  if (count > ADD_MAX_PARTIALS) count = ADD_MAX_PARTIALS;
+  memcpy(dst, amps, sizeof(float) * (size_t)count);
+  memset(dst + count, 0, sizeof(float) * (size_t)(ADD_MAX_PARTIALS - count));
+
+  // Swap our finished buffer into the middle and take the old middle back
+  unsigned old = atomic_exchange_explicit(&t->middle, t->back | ADD_FRESH,
+                                          memory_order_acq_rel);
+  t->back = old & 3u;
+}
+
+// Audio thread: adopt the newest published table, if there is one.
+static const float* latest_amps(AddAmpBuffer* t) {
+  if (atomic_load_explicit(&t->middle, memory_order_relaxed) & ADD_FRESH) {
+    unsigned old = atomic_exchange_explicit(&t->middle, t->front,
+                                            memory_order_acq_rel);
+    t->front = old & 3u;
+  }
+  return t->amps[t->front];
+}
+
+static void render_voice(AdditiveVoice* v, float* out, int n) {
+  const float* target = latest_amps(&v->targets);
+  float inv_n = 1.0f / (float)n;
+
+  for (int g = 0; g < v->audible; g += ADD_LANES) {
+    float re[ADD_LANES], im[ADD_LANES], rr[ADD_LANES], ri[ADD_LANES];
+    float a[ADD_LANES], da[ADD_LANES];
+    for (int k = 0; k < ADD_LANES; k++) {
+      re[k] = v->re[g + k];
+      im[k] = v->im[g + k];
+      rr[k] = v->rot_re[g + k];
+      ri[k] = v->rot_im[g + k];
+      a[k] = v->amp[g + k];
+      // Ramp to the new amplitude across the block: no zipper noise
+      da[k] = (target[g + k] - a[k]) * inv_n;
+    }
+
+    for (int i = 0; i < n; i++) {
+      float s[ADD_LANES];
+      for (int k = 0; k < ADD_LANES; k++) {
+        float nr = re[k] * rr[k] - im[k] * ri[k];
+        float ni = re[k] * ri[k] + im[k] * rr[k];
+        re[k] = nr;
+        im[k] = ni;
+        a[k] += da[k];
+        s[k] = a[k] * ni;
+      }
+      out[i] += ((s[0] + s[1]) + (s[2] + s[3])) +
+                ((s[4] + s[5]) + (s[6] + s[7]));
+    }
+
+    for (int k = 0; k < ADD_LANES; k++) {
+      // Rounding slowly grows or shrinks the phasor; pull it back to the
+      // unit circle once per block (first-order Newton step).
+      float m = 1.5f - 0.5f * (re[k] * re[k] + im[k] * im[k]);
+      v->re[g + k] = re[k] * m;
+      v->im[g + k] = im[k] * m;
+      v->amp[g + k] = a[k];
+    }
+  }
+}
+
+bool additive_render(AdditiveBank* ab, float* out, int n) {
+  memset(out, 0, sizeof(float) * (size_t)n);
+  float voice_buf[1024];
+  bool sounding = false;
+
+  for (int vi = 0; vi < ADD_MAX_VOICES; vi++) {
+    AdditiveVoice* v = &ab->voices[vi];
+    if (v->level == 0.0f && v->level_target == 0.0f) continue;  // Idle
+    sounding = true;
+
+    for (int off = 0; off < n; off += 1024) {
+      int m = n - off < 1024 ? n - off : 1024;
+      memset(voice_buf, 0, sizeof(float) * (size_t)m);
+      render_voice(v, voice_buf, m);
+
+      // Linear attack / release towards the target level
+      float level = v->level;
+      for (int i = 0; i < m; i++) {
+        float d = v->level_target - level;
+        if (d > v->level_rate) d = v->level_rate;
+        if (d < -v->level_rate) d = -v->level_rate;
+        level += d;
+        out[off + i] += voice_buf[i] * level;
+      }
+      v->level = level;
+    }
+  }
+  return sounding;
+}
+
+void additive_mix(AdditiveBank* ab, int16_t* out, int n) {
+  float tmp[1024];
+  for (int off = 0; off < n; off += 1024) {
+    int m = n - off < 1024 ? n - off : 1024;
+    if (!additive_render(ab, tmp, m)) continue;
+    for (int i = 0; i < m; i++) {
+      int mixed = out[off + i] + (int)(tmp[i] * 32767.0f);
+      if (mixed > 32767) mixed = 32767;
+      if (mixed < -32768) mixed = -32768;
+      out[off + i] = (int16_t)mixed;
+    }
+  }
+}
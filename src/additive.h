@@ -0,0 +1,78 @@
+#ifndef ADDITIVE_H
+#define ADDITIVE_H
+
+// --- ADDITIVE OSCILLATOR BANK ---
+// Hundreds of sine partials per voice, the brute-force counterpart to the
+// single FM carrier. Each partial is a recursive quadrature oscillator (a
+// rotating complex phasor, no sin() per sample), processed eight partials
+// at a time so the rotations vectorise. Partials at or above Nyquist are
+// dropped per voice, so high notes cost less than low ones.
+//
+// Partial amplitudes can be rewritten from the main thread every frame
+// without locks: each voice has a triple buffer, and the audio thread picks
+// up the newest table at the start of a block and ramps towards it.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ADD_MAX_VOICES 8
+#define ADD_MAX_PARTIALS 256
+#define ADD_LANES 8
+
+// Lock-free hand-off of one amplitude table (single writer, single reader).
+typedef struct {
+  float amps[3][ADD_MAX_PARTIALS];
+  _Atomic unsigned middle;  // Buffer index, | ADD_FRESH when unread
+  unsigned back;            // Owned by the writer
+  unsigned front;           // Owned by the audio thread
+} AddAmpBuffer;
+
+#define ADD_FRESH 4u
+
+typedef struct {
+  // Oscillator state per partial, structure-of-arrays
+  float re[ADD_MAX_PARTIALS];
+  float im[ADD_MAX_PARTIALS];  // Output is the imaginary (sine) part
+  float rot_re[ADD_MAX_PARTIALS];
+  float rot_im[ADD_MAX_PARTIALS];
+  float amp[ADD_MAX_PARTIALS];    // Current (smoothed) amplitudes
+  float ratio[ADD_MAX_PARTIALS];  // Partial frequency / fundamental, rising
+
+  AddAmpBuffer targets;
+  double freq;
+  int audible;  // Partials below Nyquist, rounded up to ADD_LANES
+  float level;  // Note envelope
+  float level_target;
+  float level_rate;  // Per-sample ramp speed
+} AdditiveVoice;
+
+typedef struct {
+  AdditiveVoice voices[ADD_MAX_VOICES];
+  double sample_rate;
+} AdditiveBank;
+
+// Voices start harmonic (ratio k+1) with a 1/k sawtooth-like spectrum.
+void additive_init(AdditiveBank* ab, double sample_rate);
+
+// Optional inharmonic partial ratios (ascending). Call before notes start.
+void additive_set_ratios(AdditiveBank* ab, int voice, const float* ratios,
+                         int count);
+
+// Note control is audio thread only, or before the device starts.
+// attack/release are in seconds.
+void additive_note_on(AdditiveBank* ab, int voice, double freq, float level,
+                      double attack);
+void additive_note_off(AdditiveBank* ab, int voice, double release);
+
+// Main thread, any rate, no lock: publish a new amplitude table for a voice.
+// Partials past `count` are silenced.
+void additive_set_amps(AdditiveBank* ab, int voice, const float* amps,
+                       int count);
+
+// Render every sounding voice into out (overwrites). Idle voices cost
+// nothing; returns false when they all were.
+bool additive_render(AdditiveBank* ab, float* out, int n);
+void additive_mix(AdditiveBank* ab, int16_t* out, int n);
+
+#endif
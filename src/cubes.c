@@ -0,0 +1,187 @@
+#include "cubes.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "radix.h"
+
+// The original ten, unchanged so the default scene looks the same
+static const float k_classic[10][3] = {
+    {0.0f, 0.0f, 0.0f},    {2.0f, 5.0f, -15.0f}, {-1.5f, -2.2f, -2.5f},
+    {-3.8f, -2.0f, -12.3f}, {2.4f, -0.4f, -3.5f}, {-1.7f, 3.0f, -7.5f},
+    {1.3f, -2.0f, -2.5f},  {1.5f, 2.0f, -2.5f},  {1.5f, 0.2f, -1.5f},
+    {-1.3f, 1.0f, -1.5f}};
+
+// splitmix64: a well-mixed 64-bit value per (index, stream)
+static uint64_t mix(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+// Uniform in [0, 1)
+static float unit(uint64_t i, int stream) {
+  return (float)(mix(i * 8 + (uint64_t)stream) >> 40) * (1.0f / 16777216.0f);
+}
+
+// Spread the low 10 bits of `v` three apart, for interleaving
+static uint64_t spread(uint32_t v) {
+  uint64_t x = v & 0x3FF;
+  x = (x | (x << 16)) & 0x30000FFull;
+  x = (x | (x << 8)) & 0x300F00Full;
+  x = (x | (x << 4)) & 0x30C30C3ull;
+  x = (x | (x << 2)) & 0x9249249ull;
+  return x;
+}
+
+// Position in the box as a 10-bit grid coordinate
+static uint32_t grid(float unit_pos) {
+  int g = (int)(unit_pos * 1024.0f);
+  return (uint32_t)(g < 0 ? 0 : g > 1023 ? 1023 : g);
+}
+
+// Reorder the scattered centres (not the axes or phases, which stay with
+// the index) along a Morton curve through the box
+static int morton_order(CubeField* f, float side) {
+  int n = f->count - 10;
+  if (n < 2) return 1;
+  uint64_t* keys = (uint64_t*)malloc(sizeof(uint64_t) * 2 * (size_t)n);
+  uint32_t* order = (uint32_t*)malloc(sizeof(uint32_t) * 2 * (size_t)n);
+  if (!keys || !order) {
+    free(keys);
+    free(order);
+    return 0;
+  }
+  float* x = f->x + 10;
+  float* y = f->y + 10;
+  float* z = f->z + 10;
+  for (int i = 0; i < n; i++) {
+    keys[i] = spread(grid(x[i] / side + 0.5f)) |
+              (spread(grid(y[i] / side + 0.5f)) << 1) |
+              (spread(grid((-1.0f - z[i]) / side)) << 2);
+    order[i] = (uint32_t)i;
+  }
+  radix_sort(keys, order, n, keys + n, order + n);
+  // The sort's scratch holds one axis at a time while it's permuted
+  float* old = (float*)(keys + n);
+  float* axes[3] = {x, y, z};
+  for (int a = 0; a < 3; a++) {
+    memcpy(old, axes[a], sizeof(float) * (size_t)n);
+    for (int i = 0; i < n; i++) axes[a][i] = old[order[i]];
+  }
+  free(keys);
+  free(order);
+  return 1;
+}
+
+int cubes_init(CubeField* f, int count) {
+  memset(f, 0, sizeof(*f));
+  if (count < 1 || count > CUBES_MAX) return 0;
+
+  // One block for all nine arrays
+  float* block = (float*)malloc(sizeof(float) * 9 * (size_t)count);
+  if (!block) return 0;
+  f->count = count;
+  f->x = block;
+  f->y = f->x + count;
+  f->z = f->y + count;
+  f->ax = f->z + count;
+  f->ay = f->ax + count;
+  f->az = f->ay + count;
+  f->phase = f->az + count;
+  f->half_cos = f->phase + count;
+  f->half_sin = f->half_cos + count;
+
+  // Box in front of the camera (which sits at z = +3 looking down -z)
+  float side = CUBES_SPACING * cbrtf((float)count);
+  const float classic_axis[3] = {1.0f, 0.3f, 0.5f};
+  float classic_len = sqrtf(1.0f + 0.09f + 0.25f);
+
+  for (int i = 0; i < count; i++) {
+    float ax, ay, az;
+    if (i < 10) {
+      f->x[i] = k_classic[i][0];
+      f->y[i] = k_classic[i][1];
+      f->z[i] = k_classic[i][2];
+      ax = classic_axis[0];
+      ay = classic_axis[1];
+      az = classic_axis[2];
+    } else {
+      f->x[i] = (unit(i, 0) - 0.5f) * side;
+      f->y[i] = (unit(i, 1) - 0.5f) * side;
+      f->z[i] = -1.0f - unit(i, 2) * side;
+      // Random direction: uniform z and angle give a uniform unit vector
+      float cz = unit(i, 3) * 2.0f - 1.0f;
+      float a = unit(i, 4) * 6.2831853f;
+      float r = sqrtf(1.0f - cz * cz);
+      ax = r * cosf(a);
+      ay = r * sinf(a);
+      az = cz;
+    }
+    float len = i < 10 ? classic_len : 1.0f;
+    f->ax[i] = ax / len;
+    f->ay[i] = ay / len;
+    f->az[i] = az / len;
+    // 20 degrees per index, kept small so float precision holds at millions
+    f->phase[i] = (float)((20LL * i) % 360);
+    double h = f->phase[i] * (M_PI / 360.0);
+    f->half_cos[i] = (float)cos(h);
+    f->half_sin[i] = (float)sin(h);
+  }
+  if (!morton_order(f, side)) {
+    cubes_free(f);
+    return 0;
+  }
+  return 1;
+}
+
+void cubes_free(CubeField* f) {
+  free(f->x);
+  memset(f, 0, sizeof(*f));
+}
+
+void cubes_place(const CubeField* f, TransformSet* t) {
+  int n = f->count < t->count ? f->count : t->count;
+  memcpy(t->px, f->x, sizeof(float) * (size_t)n);
+  memcpy(t->py, f->y, sizeof(float) * (size_t)n);
+  memcpy(t->pz, f->z, sizeof(float) * (size_t)n);
+  for (int i = 0; i < n; i++) t->sx[i] = t->sy[i] = t->sz[i] = 1.0f;
+}
+
+// Restrict parameters (the compiler can't otherwise prove the field's and
+// the set's arrays don't overlap) and fixed-size groups, so the lane loop
+// vectorises
+static void spin_range(const float* restrict hc, const float* restrict hs,
+                       const float* restrict ax, const float* restrict ay,
+                       const float* restrict az, float* restrict qx,
+                       float* restrict qy, float* restrict qz,
+                       float* restrict qw, float c, float s, int begin,
+                       int end) {
+  int i = begin;
+  for (; i + TRANSFORM_LANES <= end; i += TRANSFORM_LANES) {
+    for (int l = 0; l < TRANSFORM_LANES; l++) {
+      float sn = hs[i + l] * c + hc[i + l] * s;
+      qx[i + l] = ax[i + l] * sn;
+      qy[i + l] = ay[i + l] * sn;
+      qz[i + l] = az[i + l] * sn;
+      qw[i + l] = hc[i + l] * c - hs[i + l] * s;
+    }
+  }
+  for (; i < end; i++) {
+    float sn = hs[i] * c + hc[i] * s;
+    qx[i] = ax[i] * sn;
+    qy[i] = ay[i] * sn;
+    qz[i] = az[i] * sn;
+    qw[i] = hc[i] * c - hs[i] * s;
+  }
+}
+
+void cubes_spin(const CubeField* f, float turn, int begin, int end,
+                TransformSet* t) {
+  double h = turn * (M_PI / 360.0);
+  spin_range(f->half_cos, f->half_sin, f->ax, f->ay, f->az, t->qx, t->qy,
+             t->qz, t->qw, (float)cos(h), (float)sin(h), begin, end);
+}
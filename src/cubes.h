@@ -0,0 +1,52 @@
+#ifndef CUBES_H
+#define CUBES_H
+
+// --- CUBE FIELD ---
+// Where the spinning cubes are and how they turn. Cube i sits at a fixed
+// centre and spins about a fixed axis, at angle `phase + time * spin`
+// degrees. The first ten keep the original hand-placed layout; any beyond
+// that are scattered (deterministically, by index) through a box in front
+// of the camera that grows with the count, so density stays about the same
+// from ten cubes to millions. The scattered centres are then put in Morton
+// order, so any run of consecutive cubes (a worker chunk, say) is a compact
+// region of the box that can be culled or depth-sorted as one.
+//
+// Stored as structure-of-arrays so per-cube loops touch only the fields
+// they need and vectorise.
+
+#include "transforms.h"
+
+#define CUBES_DEFAULT 10
+#define CUBES_MAX 4000000
+#define CUBES_SPACING 2.5f  // Average distance between scattered cubes
+
+typedef struct {
+  int count;
+  float* x;  // Centre
+  float* y;
+  float* z;
+  float* ax;  // Unit rotation axis
+  float* ay;
+  float* az;
+  float* phase;  // Degrees at time 0 (20 per index, as the original loop)
+  float* half_cos;  // cos and sin of half the phase, for cubes_spin
+  float* half_sin;
+} CubeField;
+
+// Lay out `count` cubes (1..CUBES_MAX). Returns 0 on a bad count or if the
+// arrays couldn't be allocated (the field is left empty).
+int cubes_init(CubeField* f, int count);
+
+void cubes_free(CubeField* f);
+
+// Copy the centres into a transform set of the same size (unit scale).
+void cubes_place(const CubeField* f, TransformSet* t);
+
+// Set the rotations of cubes [begin, end) for a common spin of `turn`
+// degrees: quaternion (axis * sin(h), cos(h)) with h = (phase + turn) / 2.
+// The per-cube half-phase is rotated by turn / 2 with one complex multiply,
+// so there's no sin/cos per cube and the loop vectorises.
+void cubes_spin(const CubeField* f, float turn, int begin, int end,
+                TransformSet* t);
+
+#endif
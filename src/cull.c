@@ -0,0 +1,63 @@
+#include "cull.h"
+
+#include <math.h>
+
+void cull_planes(Frustum* f, const float m[16]) {
+  // Row r of the matrix is (m[r], m[4 + r], m[8 + r], m[12 + r]). The
+  // planes are the last row plus and minus each of the first three: left,
+  // right, bottom, top, near, far.
+  for (int p = 0; p < 6; p++) {
+    int r = p / 2;
+    float sign = p % 2 == 0 ? 1.0f : -1.0f;
+    float a = m[3] + sign * m[r];
+    float b = m[7] + sign * m[4 + r];
+    float c = m[11] + sign * m[8 + r];
+    float d = m[15] + sign * m[12 + r];
+    float len = sqrtf(a * a + b * b + c * c);
+    float inv = len > 0.0f ? 1.0f / len : 0.0f;  // Degenerate: always in
+    f->nx[p] = a * inv;
+    f->ny[p] = b * inv;
+    f->nz[p] = c * inv;
+    f->d[p] = d * inv;
+  }
+}
+
+int cull_spheres(const Frustum* f, const float* x, const float* y,
+                 const float* z, float radius, int begin, int end,
+                 uint32_t* out) {
+  int n = 0;
+  int i = begin;
+  for (; i + TRANSFORM_LANES <= end; i += TRANSFORM_LANES) {
+    // Inside every plane: distance of the centre >= -radius
+    int inside[TRANSFORM_LANES];
+    for (int l = 0; l < TRANSFORM_LANES; l++) inside[l] = 1;
+    for (int p = 0; p < 6; p++) {
+      float nx = f->nx[p], ny = f->ny[p], nz = f->nz[p];
+      float limit = -radius - f->d[p];
+      for (int l = 0; l < TRANSFORM_LANES; l++) {
+        inside[l] &= x[i + l] * nx + y[i + l] * ny + z[i + l] * nz >= limit;
+      }
+    }
+
+    // Most groups of a big field are all out: skip them outright
+    int any = 0;
+    for (int l = 0; l < TRANSFORM_LANES; l++) any |= inside[l];
+    if (!any) continue;
+
+    // Every index is written, only the visible ones are kept
+    for (int l = 0; l < TRANSFORM_LANES; l++) {
+      out[n] = (uint32_t)(i + l);
+      n += inside[l];
+    }
+  }
+  for (; i < end; i++) {
+    int in = 1;
+    for (int p = 0; p < 6; p++) {
+      in &= x[i] * f->nx[p] + y[i] * f->ny[p] + z[i] * f->nz[p] >=
+            -radius - f->d[p];
+    }
+    out[n] = (uint32_t)i;
+    n += in;
+  }
+  return n;
+}
@@ -0,0 +1,37 @@
+#ifndef CULL_H
+#define CULL_H
+
+// --- FRUSTUM CULLING ---
+// Which instances can be on screen at all. The six clip planes are pulled
+// straight out of a projection * view matrix, and bounding spheres are
+// tested against them TRANSFORM_LANES at a time: each plane is applied to
+// the whole group in one plain loop over structure-of-arrays centres, which
+// the compiler vectorises, and the survivors are then written out as a
+// compact list of indices without a branch per instance.
+//
+// Conservative: a sphere that only touches the frustum counts as visible,
+// so nothing on screen is ever dropped.
+//
+// Ranges are independent, so worker threads can each take a slice.
+
+#include <stdint.h>
+
+#include "transforms.h"
+
+typedef struct {
+  // Plane p is nx*x + ny*y + nz*z + d >= 0 on the inside, with (nx, ny, nz)
+  // of unit length, so the left side is a signed distance
+  float nx[6], ny[6], nz[6], d[6];
+} Frustum;
+
+// Planes of the view volume of a column-major matrix (clip = m * world), in
+// GL clip space (-w <= x, y, z <= w).
+void cull_planes(Frustum* f, const float m[16]);
+
+// Indices of the spheres in [begin, end), all of radius `radius`, that
+// intersect the frustum, written in order to out[0..]. Returns how many.
+int cull_spheres(const Frustum* f, const float* x, const float* y,
+                 const float* z, float radius, int begin, int end,
+                 uint32_t* out);
+
+#endif
@@ -3,124 +3,384 @@
 
 // --- AUDIO INCLUDES (MacOS) ---
 // We need these specifically for the AudioQueue API
+#ifdef __APPLE__
 #include <AudioToolbox/AudioToolbox.h>
 #include <CoreAudio/CoreAudio.h>
+#endif
 // ------------------------------
 
 #include <cglm/cglm.h>
+#include <limits.h>
 #include <math.h>
 #include <pthread.h>
 #include <stb_image.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
-
-// Global mutex to protect audio state between Main Thread and Audio Thread
-static pthread_mutex_t g_mutex;
-
-// --- AUDIO GLOBALS & FUNK ENGINE ---
-// Holds the state of our FM synthesizer
-typedef struct {
-  double phase;
-  double freq;
-  double vol;
-  int samples_left;
-  double mod_phase;  // Phase for the FM modulator (the "funk" texture)
-} AudioState;
-
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "recorder.h"
+#include "rt.h"
+#include "additive.h"
+#include "cubes.h"
+#include "cull.h"
+#include "dynamics.h"
+#include "granular.h"
+#include "headless.h"
+#include "meter.h"
+#include "netclock.h"
+#include "osc.h"
+#include "params.h"
+#include "perf.h"
+#include "pluck.h"
+#include "profiler.h"
+#include "radix.h"
+#include "renderqueue.h"
+#include "resample.h"
+#include "sampler.h"
+#include "schedule.h"
+#include "stream.h"
+#include "synth.h"
+#include "transforms.h"
+#include "workers.h"
+
+// --- AUDIO GLOBALS ---
+#define AUDIO_FRAMES 1024  // Frames per callback block
+#define AUDIO_MAX_RATE 192000
+#define AUDIO_MAX_CHANNELS 8
+
+// The engine renders mono at g_engine_rate (--rate); the device plays
+// g_channels copies of it at g_device_rate (--device-rate, --channels).
+// When the two rates differ, g_rs converts in between. Set before the
+// device starts and never changed afterwards.
+static int g_engine_rate = (int)SYNTH_SAMPLE_RATE;
+static int g_device_rate = (int)SYNTH_SAMPLE_RATE;
+static int g_channels = 1;
+static Resampler g_rs;
+
+#ifdef __APPLE__
 static AudioQueueRef g_q = NULL;
 static AudioQueueBufferRef g_bufs[3];
+#else
+static pthread_t g_dev_thread;
+static atomic_bool g_dev_running;
+static int16_t g_dev_buf[AUDIO_FRAMES * AUDIO_MAX_CHANNELS];
+#endif
 static AudioState g_as;
+static Sampler g_sampler;  // Memory-mapped WAV one-shots and loops
+static PluckBank g_pluck;  // Karplus-Strong strings (plucks and strikes)
+static GranularEngine g_grains;  // Evolving texture under the visuals
+static AdditiveBank g_additive;  // Drone whose spectrum follows the visuals
+// Source for the grains: a few seconds of the bass line rendered at startup
+static float g_grain_src[4 * AUDIO_MAX_RATE];
+
+// Automatable controls. main() writes targets lock-free; the audio thread
+// glides g_as and the grain position towards them every PARAM_SLICE samples.
+static ParamBank g_params;
+static int g_p_vol, g_p_index, g_p_ratio, g_p_grain_pos;
+
+// Master bus: every voice is summed here in float, then compressed and
+// limited before the one conversion to 16-bit.
+static Dynamics g_dyn;
+static float g_bus[AUDIO_FRAMES];
+static float g_voice_buf[AUDIO_FRAMES];
+static int16_t g_pcm_buf[AUDIO_FRAMES];
+// Engine-rate output and, when resampling, the device-rate result
+static float g_engine_buf[AUDIO_FRAMES];
+static float g_out_buf[AUDIO_FRAMES];
+
+// Output levels for the render loop (published lock-free once per callback)
+static Meter g_meter;
+
+// Opt-in real-time hardening (--realtime). Only the audio thread touches
+// g_rt_entered; g_rt_report is read by main once the thread says it's ready.
+static bool g_rt_mode = false;
+static bool g_rt_entered = false;
+static RtReport g_rt_report;
+
+// --- SHOW TIMELINE ---
+// The sequencer runs on g_clock's timeline: local by default, shared with
+// other machines under --lead / --follow. The render loop turns each tick
+// into an engine sample and queues its notes on g_sched ahead of time, so
+// beats land on their exact sample rather than on the next frame.
+#define SEQ_TEMPO 8.0       // Ticks per second (480 BPM 16ths)
+#define SEQ_LOOKAHEAD 0.1   // Seconds of ticks queued beyond the latency
+enum { SCHED_SLAP, SCHED_PLUCK, SCHED_STRIKE, SCHED_SAMPLE };
+static NetClock g_clock;
+static SchedQueue g_sched;
+// Monotonic time at which engine sample 0 was (in effect) rendered, written
+// by the audio thread. 0 until the first callback.
+static _Atomic long long g_audio_anchor_ns;
+static long long g_anchor_cur = LLONG_MAX;   // Audio thread only
+static long long g_anchor_prev = LLONG_MAX;  // Audio thread only
+static long long g_anchor_since = 0;         // Audio thread only
+
+// Optional OSC control surface (--osc PORT). The server thread feeds two
+// lock-free rings: notes and parameters for the audio thread, visual
+// controls for the render loop. Each consumer keeps its own latency stats.
+enum {
+  OSC_NOTE,        // /note freq: FM slap
+  OSC_PLUCK,       // /pluck freq [velocity]
+  OSC_STRIKE,      // /strike freq [velocity]
+  OSC_SAMPLE,      // /sample id [volume]
+  OSC_PARAM,       // /param/<name> value
+  OSC_SPIN,        // /visual/spin degrees_per_sec
+  OSC_BACKGROUND,  // /visual/background r g b
+  OSC_FOV,         // /visual/fov degrees
+};
+static bool g_osc_on = false;  // Main thread only
+static OscServer g_osc;
+static OscQueue g_osc_audio;
+static OscQueue g_osc_render;
+static OscLatency g_osc_audio_lat;   // Audio thread only
+static OscLatency g_osc_render_lat;  // Render loop only
+
+// Optional tap of everything we play (--record). Opened before the device
+// starts, so the audio thread can read g_recording without synchronization.
+static bool g_recording = false;
+static Recorder g_rec;
+
+// Add one float voice buffer into the master bus
+static void bus_add(const float* src, int n) {
+  for (int i = 0; i < n; i++) g_bus[i] += src[i];
+}
+
+// Sum every voice for n (<= AUDIO_FRAMES) samples into g_bus and run the
+// master dynamics. Each stage reports whether it made any sound, so idle
+// voices are never added; returns false when the bus is silent.
+static bool audio_mix_block(int n) {
+  bool live = false;
+
+  // Run the FM "slap bass" voice (see synth.c); it speaks 16-bit natively.
+  // It renders in control-rate slices so automated parameters glide.
+  params_begin(&g_params);
+  for (int s = 0; s < n; s += PARAM_SLICE) {
+    int m = n - s < PARAM_SLICE ? n - s : PARAM_SLICE;
+    g_as.vol = params_get(&g_params, g_p_vol);
+    g_as.mod_index = params_get(&g_params, g_p_index);
+    g_as.mod_ratio = params_get(&g_params, g_p_ratio);
+    live |= synth_render(&g_as, g_pcm_buf + s, m);
+    params_advance(&g_params, m);
+  }
+  if (live) {
+    for (int i = 0; i < n; i++) g_bus[i] = g_pcm_buf[i] * (1.0f / 32768.0f);
+  } else {
+    memset(g_bus, 0, sizeof(float) * (size_t)n);
+  }
+
+  // Layer any playing samples on top of the FM voice
+  live |= sampler_mix(&g_sampler, g_bus, n);
+
+  // Physically modelled strings ring over the top
+  if (pluck_render(&g_pluck, g_voice_buf, n)) {
+    bus_add(g_voice_buf, n);
+    live = true;
+  }
+
+  // Granular pad underneath everything, reading where main() last scanned
+  g_grains.params.position = params_get(&g_params, g_p_grain_pos);
+  if (granular_render(&g_grains, g_voice_buf, n)) {
+    bus_add(g_voice_buf, n);
+    live = true;
+  }
+
+  // Additive drone; its partial amplitudes arrive lock-free from main()
+  if (additive_render(&g_additive, g_voice_buf, n)) {
+    bus_add(g_voice_buf, n);
+    live = true;
+  }
+
+  // Overlapping notes get compressed and limited instead of hard-clipping
+  live = dynamics_process(&g_dyn, g_bus, n, !live);
+  meter_process(&g_meter, g_bus, n, !live);
+  meter_note_gain(&g_meter, dynamics_take_min_gain(&g_dyn));
+  return live;
+}
+
+// Start the sequencer notes that are due at the current sample
+static void audio_sched_play(void) {
+  SchedEvent ev;
+  while (sched_pop_due(&g_sched, g_params.pos, &ev)) {
+    switch (ev.kind) {
+      case SCHED_SLAP:
+        synth_slap(&g_as, ev.a);
+        break;
+      case SCHED_PLUCK:
+      case SCHED_STRIKE:
+        pluck_trigger(&g_pluck, ev.a, 0.6, 0.6, 1.5,
+                      ev.kind == SCHED_PLUCK ? PLUCK_PLUCKED : PLUCK_STRUCK);
+        break;
+      case SCHED_SAMPLE:
+        sampler_trigger(&g_sampler, ev.id, 1.0, ev.a);
+        break;
+    }
+  }
+}
+
+// Where engine sample 0 sits on the monotonic clock. Callbacks can run
+// late but never early, so the earliest (now - pos / rate) over the last
+// couple of seconds is the best estimate; the window slides so crystal
+// drift between the device and the host clock can't build up.
+static void audio_track_anchor(long long now) {
+  long long a = now - llround((double)g_params.pos * 1e9 / g_engine_rate);
+  if (now - g_anchor_since > 2000000000LL) {
+    g_anchor_prev = g_anchor_cur;
+    g_anchor_cur = a;
+    g_anchor_since = now;
+  } else if (a < g_anchor_cur) {
+    g_anchor_cur = a;
+  }
+  long long best = g_anchor_prev < g_anchor_cur ? g_anchor_prev : g_anchor_cur;
+  atomic_store_explicit(&g_audio_anchor_ns, best, memory_order_relaxed);
+}
+
+// Render n engine-rate samples into out, cutting blocks where the next
+// automation event is due. Returns false if all of it is silent.
+static bool audio_engine_render(float* out, int n) {
+  bool live = false;
+  for (int off = 0; off < n;) {
+    int m = n - off < AUDIO_FRAMES ? n - off : AUDIO_FRAMES;
+    // Cut where the next automation or sequencer event is due, and play
+    // the sequencer events that are due now
+    m = params_until_event(&g_params, m);
+    m = sched_until(&g_sched, g_params.pos, m);
+    audio_sched_play();
+    if (audio_mix_block(m)) {
+      memcpy(out + off, g_bus, sizeof(float) * (size_t)m);
+      live = true;
+    } else {
+      memset(out + off, 0, sizeof(float) * (size_t)m);
+    }
+    off += m;
+  }
+  return live;
+}
+
+// Convert to 16-bit and copy the mono mix to every device channel
+static void audio_write_device(int16_t* out, const float* src, int n,
+                               bool live) {
+  if (!live) {
+    memset(out, 0, sizeof(int16_t) * (size_t)(n * g_channels));
+  } else if (g_channels == 1) {
+    for (int i = 0; i < n; i++) out[i] = (int16_t)(src[i] * 32767.0f);
+  } else {
+    for (int i = 0; i < n; i++) {
+      int16_t v = (int16_t)(src[i] * 32767.0f);
+      for (int c = 0; c < g_channels; c++) out[i * g_channels + c] = v;
+    }
+  }
+}
+
+// Apply the notes and parameter moves that arrived over OSC since the last
+// callback. Lock- and allocation-free, like everything else in the callback.
+static void audio_osc_drain(void) {
+  OscEvent ev;
+  long long now = osc_now_ns();
+  while (osc_queue_pop(&g_osc_audio, &ev)) {
+    osc_latency_note(&g_osc_audio_lat, ev.recv_ns, now);
+    if (ev.count < 1) continue;
+    float level = ev.count > 1 ? ev.v[1] : -1.0f;
+    switch (ev.tag) {
+      case OSC_NOTE:
+        if (ev.v[0] > 0.0f) synth_slap(&g_as, ev.v[0]);
+        break;
+      case OSC_PLUCK:
+      case OSC_STRIKE:
+        pluck_trigger(&g_pluck, ev.v[0], level < 0.0f ? 0.6 : level, 0.6, 1.5,
+                      ev.tag == OSC_PLUCK ? PLUCK_PLUCKED : PLUCK_STRUCK);
+        break;
+      case OSC_SAMPLE:
+        sampler_trigger(&g_sampler, (int)ev.v[0], 1.0,
+                        level < 0.0f ? 0.8 : level);
+        break;
+      case OSC_PARAM:
+        params_set(&g_params, ev.id, ev.v[0]);
+        break;
+    }
+  }
+}
+
+// --- THE AUDIO RENDER ---
+// Shared body of every backend's callback: fills N interleaved device frames.
+static void audio_render(int16_t* out, int N, bool os_managed) {
+  // The whole callback must be allocation- and lock-free; the debug guard
+  // aborts if it isn't. Everything it shares with main() is atomic or a
+  // single-producer ring.
+  rt_guard_enter();
+
+  if (g_rt_mode && !g_rt_entered) {
+    // First block on this thread: raise priority and prefault the stack
+    // before we start producing audio for real. The guard only arms at the
+    // end of this, so its one-off setup calls aren't trapped.
+    rt_audio_thread_enter(&g_rt_report, os_managed);
+    g_rt_entered = true;
+  }
+
+  audio_track_anchor(netclock_mono_ns());
+  audio_osc_drain();  // Two atomic loads when OSC is off
+
+  bool convert = g_engine_rate != g_device_rate;
+  for (int off = 0; off < N;) {
+    int n = N - off < AUDIO_FRAMES ? N - off : AUDIO_FRAMES;
+    bool live;
+    if (convert) {
+      // Render exactly the engine frames these n device frames need
+      int most = resampler_output_frames(&g_rs, AUDIO_FRAMES);
+      if (n > most) n = most;
+      int in_n = resampler_input_frames(&g_rs, n);
+      live = audio_engine_render(g_engine_buf, in_n);
+      live = resampler_process(&g_rs, g_engine_buf, in_n, g_out_buf, n, !live);
+    } else {
+      live = audio_engine_render(g_out_buf, n);
+    }
+    audio_write_device(out + off * g_channels, g_out_buf, n, live);
+    off += n;
+  }
+
+  // Copy the finished block to the recording ring (never blocks)
+  if (g_recording) recorder_push(&g_rec, out, N * g_channels);
 
+  // Hand this callback's levels to the render loop (never blocks)
+  meter_publish(&g_meter);
+
+  rt_guard_leave();
+}
+
+#ifdef __APPLE__
 // --- THE AUDIO CALLBACK ---
 // This runs on a separate high-priority OS thread.
 // It asks us to fill a buffer with PCM data.
 static void AQCallback(void* ud, AudioQueueRef q, AudioQueueBufferRef buf) {
   (void)ud;
-  const double sr = 44100.0;
   int16_t* out = (int16_t*)buf->mAudioData;
-  int N = (int)buf->mAudioDataBytesCapacity / 2;
-
-  // [Concurrency Check]
-  // We MUST lock here. If the main thread changes the note frequency while
-  // we are halfway through calculating this buffer, the waveform will snap,
-  // causing a nasty "pop".
-  pthread_mutex_lock(&g_mutex);
-
-  // Carrier frequency setup
-  double step = (2.0 * M_PI * g_as.freq) / sr;
-
-  // Modulator setup (2.0 ratio gives a harmonic/square-ish tone)
-  double mod_step = step * 2.0;
-
-  for (int i = 0; i < N; i++) {
-    if (g_as.samples_left > 0) {
-      // 1. Envelope Generator
-      // Simple attack/decay for a percussive "slap bass" feel
-      int tot = (int)(0.25 * sr);
-      int age = tot - g_as.samples_left;
-      double env = 1.0;
-
-      if (age < 100)
-        env = (double)age / 100.0;  // Fast attack
-      else
-        env = exp(-15.0 * ((double)(age - 100) / sr));  // Exp decay
-
-      // 2. Advance Phases
-      g_as.phase += step;
-      g_as.mod_phase += mod_step;
-
-      // Wrap phases to keep precision happy
-      if (g_as.phase > 2.0 * M_PI) g_as.phase -= 2.0 * M_PI;
-      if (g_as.mod_phase > 2.0 * M_PI) g_as.mod_phase -= 2.0 * M_PI;
-
-      // 3. FM Synthesis
-      // Modulate the carrier's phase with the modulator's amplitude
-      double modulation = sin(g_as.mod_phase) * 3.0 * env;
-      double raw_wave = sin(g_as.phase + modulation);
-
-      // 4. Hard Clip / Distortion
-      // Keeps it loud and gritty
-      if (raw_wave > 0.8) raw_wave = 0.8;
-      if (raw_wave < -0.8) raw_wave = -0.8;
-
-      // Output 16-bit signed integer
-      out[i] = (int16_t)(raw_wave * 32767.0 * g_as.vol * env);
-      g_as.samples_left--;
-    } else {
-      // Silence if no note is playing
-      out[i] = 0;
-    }
-  }
+  int bytes_per_frame = 2 * g_channels;
+  int N = (int)buf->mAudioDataBytesCapacity / bytes_per_frame;
 
-  // Done modifying shared state
-  pthread_mutex_unlock(&g_mutex);
+  audio_render(out, N, true);
 
   // Tell the OS how many bytes we wrote
-  buf->mAudioDataByteSize = (UInt32)(N * 2);
+  buf->mAudioDataByteSize = (UInt32)(N * bytes_per_frame);
 
   // Hand the buffer back to the OS to play
   AudioQueueEnqueueBuffer(q, buf, 0, NULL);
 }
 
 // Setup the Mac AudioQueue system
-static int audio_init(void) {
-  pthread_mutex_init(&g_mutex, NULL);
-  memset(&g_as, 0, sizeof(g_as));
-  g_as.freq = 55.0;  // Start at A1
-  g_as.vol = 0.5;
-  g_as.samples_left = 0;
-
-  // Define standard CD-quality audio format (16-bit PCM)
+static int audio_device_open(void) {
+  // Interleaved 16-bit PCM at the device rate and channel count
   AudioStreamBasicDescription asbd = {0};
-  asbd.mSampleRate = 44100.0;
+  asbd.mSampleRate = g_device_rate;
   asbd.mFormatID = kAudioFormatLinearPCM;
   asbd.mFormatFlags =
       kLinearPCMFormatFlagIsSignedInteger | kLinearPCMFormatFlagIsPacked;
   asbd.mBitsPerChannel = 16;
-  asbd.mChannelsPerFrame = 1;  // Mono
-  asbd.mBytesPerFrame = 2;
+  asbd.mChannelsPerFrame = (UInt32)g_channels;
+  asbd.mBytesPerFrame = (UInt32)(2 * g_channels);
   asbd.mFramesPerPacket = 1;
-  asbd.mBytesPerPacket = 2;
+  asbd.mBytesPerPacket = (UInt32)(2 * g_channels);
 
   if (AudioQueueNewOutput(&asbd, AQCallback, NULL, NULL, NULL, 0, &g_q) !=
           noErr ||
@@ -128,83 +388,1119 @@ static int audio_init(void) {
     return 0;
 
   // Allocate 3 buffers. This triple-buffering ensures smooth playback.
-  const UInt32 BYTES = 1024 * 2;
+  const UInt32 BYTES = (UInt32)(AUDIO_FRAMES * 2 * g_channels);
+  bool prefaulted = true;
   for (int i = 0; i < 3; i++) {
     AudioQueueAllocateBuffer(g_q, BYTES, &g_bufs[i]);
     g_bufs[i]->mAudioDataByteSize = BYTES;
     memset(g_bufs[i]->mAudioData, 0, BYTES);
+    if (g_rt_mode) {
+      prefaulted = rt_prefault(g_bufs[i]->mAudioData, BYTES) && prefaulted;
+    }
     // Prime the queue by enqueueing silent buffers first
     AudioQueueEnqueueBuffer(g_q, g_bufs[i], 0, NULL);
   }
+  g_rt_report.buffers_prefaulted = g_rt_mode && prefaulted;
   return AudioQueueStart(g_q, NULL) == noErr;
 }
 
-// Trigger a new note (Producer)
-static void audio_slap(double freq) {
-  // [Concurrency Check]
-  // Lock before writing to shared frequency/phase state
-  pthread_mutex_lock(&g_mutex);
-  g_as.freq = freq;
-  g_as.phase = 0;  // Reset phase for consistent attack
-  g_as.mod_phase = 0;
-  g_as.samples_left = (int)(0.25 * 44100.0);
-  pthread_mutex_unlock(&g_mutex);
-}
-
-static void audio_shutdown(void) {
+static void audio_device_close(void) {
   if (g_q) {
     AudioQueueStop(g_q, true);
     AudioQueueDispose(g_q, true);
     g_q = NULL;
   }
 }
+#else
+// --- PACED DEVICE THREAD (non-Apple) ---
+// There's no native output backend outside CoreAudio yet, so this thread
+// plays the part of the device: it pulls one block per period on an absolute
+// clock, exactly like the OS would, and the rest of the engine can't tell.
+static void* audio_device_main(void* arg) {
+  (void)arg;
+  const long period_ns = (long)(AUDIO_FRAMES * 1e9 / g_device_rate);
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  while (atomic_load_explicit(&g_dev_running, memory_order_acquire)) {
+    audio_render(g_dev_buf, AUDIO_FRAMES, false);
+
+    next.tv_nsec += period_ns;
+    while (next.tv_nsec >= 1000000000L) {
+      next.tv_nsec -= 1000000000L;
+      next.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+  }
+  return NULL;
+}
+
+static int audio_device_open(void) {
+  if (g_rt_mode) {
+    g_rt_report.buffers_prefaulted = rt_prefault(g_dev_buf, sizeof(g_dev_buf));
+  }
+  atomic_store(&g_dev_running, true);
+  if (pthread_create(&g_dev_thread, NULL, audio_device_main, NULL) != 0) {
+    atomic_store(&g_dev_running, false);
+    return 0;
+  }
+  return 1;
+}
+
+static void audio_device_close(void) {
+  if (atomic_exchange(&g_dev_running, false)) {
+    pthread_join(g_dev_thread, NULL);
+  }
+}
+#endif
+
+// Render a seeded stretch of the groove offline and spread slow, pitched-down
+// grains across it. Runs before the device starts, so no lock is needed.
+static void audio_grains_init(void) {
+  static int16_t pcm[4096];
+  const int frames = 4 * g_engine_rate;
+  AudioState as;
+  SynthSeq seq;
+  synth_init(&as, g_engine_rate);
+  synth_seq_init(&seq, 0xF00Du);
+  for (int off = 0; off < frames; off += 4096) {
+    int n = frames - off < 4096 ? frames - off : 4096;
+    synth_seq_render(&as, &seq, pcm, n);
+    for (int i = 0; i < n; i++) g_grain_src[off + i] = pcm[i] / 32768.0f;
+  }
+
+  granular_init(&g_grains, g_engine_rate, 0xF00Du);
+  granular_set_source(&g_grains, g_grain_src, (size_t)frames);
+  GranularParams p = {
+      .density = 80.0,
+      .duration_sec = 0.25,
+      .position = 0.5,
+      .position_jitter = 0.1,
+      .rate = 0.5,  // An octave down for a pad-like bed
+      .rate_jitter = 0.01,
+      .amp = 0.06f,
+      .window = GRAIN_WIN_GAUSS,
+  };
+  granular_set_params(&g_grains, &p);
+}
+
+// Sweep a formant-like peak through the drone's partials. Called every
+// frame, and deliberately takes no lock: the table goes through the voice's
+// triple buffer and the audio thread ramps to it on its next block.
+static void audio_additive_sweep(double time) {
+  static float amps[128];
+  double center = 10.0 + 8.0 * sin(time * 0.5);
+  for (int k = 0; k < 128; k++) {
+    double d = (k - center) / 3.0;
+    amps[k] = (float)(0.03 / sqrt(k + 1.0) * exp(-0.5 * d * d));
+  }
+  additive_set_amps(&g_additive, 0, amps, 128);
+}
+
+// Breathe the FM index with the visuals. Called every frame with no lock;
+// the audio thread glides to the newest target.
+static void audio_fm_automate(double time) {
+  params_set(&g_params, g_p_index, (float)(3.0 + 1.5 * sin(time * 0.7)));
+}
+
+// Queue a modulator ratio change for a bar line at engine sample `at`,
+// alternating between the square-ish 2:1 and a hollower 3:1 (Producer)
+static void audio_fm_bar(long long bar, long long at) {
+  params_schedule(&g_params, g_p_ratio, at, bar % 2 ? 3.0f : 2.0f, 0.05f);
+}
+
+// Drift the grain read position through the source (Producer). A param
+// like the FM controls, so no lock; the audio thread glides to it.
+static void audio_grains_scan(double time) {
+  params_set(&g_params, g_p_grain_pos, (float)(0.5 + 0.4 * sin(time * 0.1)));
+}
+
+static int audio_init(bool realtime) {
+  synth_init(&g_as, g_engine_rate);
+  params_init(&g_params, g_engine_rate);
+  g_p_vol = params_add(&g_params, (float)g_as.vol, 0.0f, 1.0f, PARAM_LINEAR,
+                       0.02);
+  g_p_index = params_add(&g_params, (float)g_as.mod_index, 0.0f, 10.0f,
+                         PARAM_EXP, 0.05);
+  g_p_ratio = params_add(&g_params, (float)g_as.mod_ratio, 0.5f, 8.0f,
+                         PARAM_EXP, 0.05);
+  g_p_grain_pos = params_add(&g_params, 0.5f, 0.0f, 1.0f, PARAM_LINEAR, 0.05);
+  sampler_init(&g_sampler, g_engine_rate);
+  pluck_init(&g_pluck, g_engine_rate);
+  audio_grains_init();
+  additive_init(&g_additive, g_engine_rate);
+  additive_note_on(&g_additive, 0, 110.0, 0.5f, 2.0);  // A2, slow swell
+  dynamics_init(&g_dyn, g_engine_rate);
+  meter_init(&g_meter, g_engine_rate);
+  resampler_init(&g_rs, g_engine_rate, g_device_rate);
+  sched_init(&g_sched);
+  atomic_init(&g_audio_anchor_ns, 0);
+  // Empty until --osc starts a server, but always drained by the callback
+  osc_queue_init(&g_osc_audio);
+  osc_queue_init(&g_osc_render);
+
+  g_rt_mode = realtime;
+  if (g_rt_mode) {
+    rt_init(&g_rt_report);
+    // Lock what's mapped now (code, globals, DSP state). This runs before
+    // any samples are mapped so gigabytes of WAVs don't get pinned.
+    rt_lock_memory(&g_rt_report);
+  }
+  return audio_device_open();
+}
+
+// Seconds between a block being rendered and it reaching the speaker: the
+// device's queued buffers plus the limiter's look-ahead (and the rate
+// converter's delay when it's in use). Anything lining visuals up with the
+// audio should delay them by this much.
+static double audio_output_latency(void) {
+#ifdef __APPLE__
+  int queued = 3 * AUDIO_FRAMES;
+#else
+  int queued = AUDIO_FRAMES;
+#endif
+  int engine = dynamics_latency(&g_dyn);
+  if (g_engine_rate != g_device_rate) engine += resampler_latency(&g_rs);
+  return (double)queued / g_device_rate + (double)engine / g_engine_rate;
+}
+
+// True once the audio thread has placed its sample clock in time
+static bool audio_clock_ready(void) {
+  return atomic_load_explicit(&g_audio_anchor_ns, memory_order_relaxed) != 0;
+}
+
+// Engine sample that reaches the speaker at monotonic time local_ns
+// (Producer; only meaningful once audio_clock_ready)
+static long long audio_sample_at(long long local_ns) {
+  long long anchor =
+      atomic_load_explicit(&g_audio_anchor_ns, memory_order_relaxed);
+  double render = (local_ns - anchor) * 1e-9 - audio_output_latency();
+  return llround(render * g_engine_rate);
+}
+
+// Trigger a new note at engine sample `at` (Producer)
+static void audio_slap(double freq, long long at) {
+  // [Concurrency Check]
+  // No lock: the note goes through g_sched and the audio thread starts it
+  // on exactly that sample
+  sched_push(&g_sched, at, SCHED_SLAP, 0, (float)freq, 0.0f);
+}
+
+// Pluck (or strike) a modelled string (Producer)
+static void audio_pluck(double freq, PluckExcite mode, long long at) {
+  sched_push(&g_sched, at, mode == PLUCK_PLUCKED ? SCHED_PLUCK : SCHED_STRIKE,
+             0, (float)freq, 0.0f);
+}
+
+// Trigger a mapped sample at its original pitch (Producer)
+static void audio_sample(int id, double vol, long long at) {
+  sched_push(&g_sched, at, SCHED_SAMPLE, id, (float)vol, 0.0f);
+}
+
+// Start the OSC server on host:port and route its addresses. Runs after
+// audio_init so the parameter ids exist, and before any packet can arrive.
+static int control_osc_open(const char* host, int port) {
+  if (!osc_open(&g_osc, host, port)) return 0;
+  osc_route(&g_osc, "/note", OSC_NOTE, 0, &g_osc_audio);
+  osc_route(&g_osc, "/pluck", OSC_PLUCK, 0, &g_osc_audio);
+  osc_route(&g_osc, "/strike", OSC_STRIKE, 0, &g_osc_audio);
+  osc_route(&g_osc, "/sample", OSC_SAMPLE, 0, &g_osc_audio);
+  osc_route(&g_osc, "/param/volume", OSC_PARAM, g_p_vol, &g_osc_audio);
+  osc_route(&g_osc, "/param/index", OSC_PARAM, g_p_index, &g_osc_audio);
+  osc_route(&g_osc, "/param/ratio", OSC_PARAM, g_p_ratio, &g_osc_audio);
+  osc_route(&g_osc, "/visual/spin", OSC_SPIN, 0, &g_osc_render);
+  osc_route(&g_osc, "/visual/background", OSC_BACKGROUND, 0, &g_osc_render);
+  osc_route(&g_osc, "/visual/fov", OSC_FOV, 0, &g_osc_render);
+  if (!osc_start(&g_osc)) return 0;
+  g_osc_on = true;
+  printf("OSC listening on %s:%d\n", host, g_osc.port);
+  return 1;
+}
+
+static void audio_shutdown(void) {
+  // Stop the network side first so nothing new is queued
+  if (g_osc_on) osc_close(&g_osc);
+  netclock_close(&g_clock);
+  audio_device_close();
+  // Only unmap once the audio thread can no longer be reading the PCM
+  sampler_shutdown(&g_sampler);
+}
+
+// --- VISUAL GLOBALS (render loop only) ---
+#define CUBE_ATTRIB 3  // Per-instance model matrix: attribute locations 3..6
+#define INDEX_ATTRIB 7  // Per-instance cube index, for ANIM_GPU when culling
+#define CUBE_RADIUS 0.8660254f  // Bounding sphere of the unit cube
+
+// Where cube motion is computed. CPU: a model matrix per cube, uploaded
+// every frame. GPU: each cube's centre, axis and phase are uploaded once to
+// a buffer texture, and the vertex shader rotates by a time uniform, so the
+// per-frame CPU cost doesn't depend on the cube count. SIMD: the CPU path
+// for transforms that really are CPU-driven; worker threads update SoA
+// rotations and write matrices several at a time straight into the mapped
+// instance buffer.
+typedef enum { ANIM_CPU, ANIM_GPU, ANIM_SIMD, ANIM_MODES } AnimMode;
+static const char* k_anim_names[ANIM_MODES] = {"cpu", "gpu", "simd"};
+#define TRANSFORM_CHUNK 4096  // Cubes per worker chunk (256 KB of matrices)
+
+static CubeField g_cubes;
+static TransformSet g_xforms;  // ANIM_SIMD's positions, rotations, scales
+static WorkerPool g_workers;
+static float* g_instances;  // One column-major mat4 per cube (CPU scratch)
+static unsigned int g_cube_buf;  // Static cube data for ANIM_GPU...
+static unsigned int g_cube_tex;  // ...viewed as a samplerBuffer
+static int g_cube_tex_max;       // GL_MAX_TEXTURE_BUFFER_SIZE, in texels
+static int g_cube_target = CUBES_DEFAULT;  // --cubes, Up/Down arrows
+static AnimMode g_anim = ANIM_GPU;         // --anim, G key
+static int g_worker_threads = 0;           // --threads (0: one per core)
+static bool g_cull = true;                 // --cull, C key
+
+// Frustum culling. Each worker chunk compacts its visible cubes into its
+// own stretch of g_visible (chunk c's start at c * TRANSFORM_CHUNK), then a
+// running total over the chunk counts, nearest chunk first, says where each
+// stretch lands in the packed instance data, so the draw covers only what
+// can be seen and runs roughly front to back.
+static uint32_t* g_visible;
+static int* g_chunk_found;
+static int* g_chunk_offset;
+// Per chunk, a sphere around its cubes: centre then radius. The field's
+// Morton order keeps chunks compact, so this says how near each one is.
+static float* g_chunk_bounds;
+#define CHUNKS_MAX ((CUBES_MAX + TRANSFORM_CHUNK - 1) / TRANSFORM_CHUNK)
+
+// The frame's draws go through a render queue: the cubes in one instanced
+// draw, then the overlays. The title reports its state changes per frame,
+// sorted and as queued.
+static RenderQueue g_queue;
+
+// Per-frame data every program reads from one std140 uniform block, bound
+// at FRAME_BINDING and uploaded once a frame. FrameBlock mirrors the GLSL
+// layout: two mat4s, then time, then the vec2 on its 8-byte boundary.
+#define FRAME_BINDING 0
+#define FRAME_BLOCK_GLSL                  \
+  "layout (std140) uniform Frame {\n"     \
+  "   mat4 view;\n"                       \
+  "   mat4 projection;\n"                 \
+  "   float time;\n"                      \
+  "   vec2 resolution;\n"                 \
+  "};\n"
+typedef struct {
+  float view[16];
+  float projection[16];
+  float time;  // Show time in seconds
+  float pad;
+  float resolution[2];  // Framebuffer pixels
+} FrameBlock;
+
+// Everything rewritten every frame (the block above, instance matrices,
+// visible lists) goes through one ring of per-frame regions, so no upload
+// waits on a frame the GPU is still drawing
+static StreamBuffer g_stream;
+static bool g_stream_persistent = true;  // --stream persistent|unsync
+static int g_ubo_align = 256;  // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+
+// The projection is rebuilt only when the framebuffer is resized or the
+// lens changes, not every frame
+static int g_fb_width = 1280, g_fb_height = 720;
+static float g_fov = 45.0f;  // Vertical, degrees: /visual/fov
+static bool g_projection_dirty = true;
+
+// "--headless WxH" draws into an offscreen framebuffer on an EGL context
+// instead of a window (see headless.h), through the same loop. Show time is
+// simulated there: frame n is at n / --fps seconds however long it took, so
+// every run animates the same frames. Audio and the beat sequencer still
+// run on the real clock.
+static bool g_headless = false;
+static int g_headless_width = 1280, g_headless_height = 720;
+static double g_headless_fps = 60.0;  // --fps
+static bool g_quit = false;  // The window's close flag, with no window
+// "--frames N" stops after N frames, "--frames-out DIR" saves every frame
+static long long g_frame_limit = 0;
+static const char* g_frames_out = NULL;
+
+// "--bench report.json" plays a fixed script instead of the free-running
+// show, on simulated time as headless (frame n at n / --fps), so every run
+// draws the same frames: the camera flies into the cube field, looks
+// around, backs out facing away and turns home. After --bench-warmup
+// frames, frame, CPU and GPU times are recorded; at the end their
+// percentiles are written to the report and, with "--bench-baseline
+// old.json", compared with an earlier report. More than --bench-threshold
+// percent slower fails the run.
+typedef struct {
+  double at;  // Script seconds
+  float yaw;  // Degrees about y, positive turning left
+  float z;    // Camera position on z (the usual view is from 3)
+} BenchKey;
+static const BenchKey k_bench_path[] = {{0.0, 0.0f, 3.0f},
+                                        {3.0, 0.0f, -20.0f},
+                                        {6.0, 120.0f, -20.0f},
+                                        {8.0, 180.0f, 3.0f},
+                                        {10.0, 360.0f, 3.0f}};
+#define BENCH_KEYS ((int)(sizeof(k_bench_path) / sizeof(k_bench_path[0])))
+#define BENCH_CUBES 100000  // Unless --cubes says otherwise
+static const char* g_bench_out = NULL;
+static const char* g_bench_baseline = NULL;
+static int g_bench_warmup = 60;          // --bench-warmup, frames
+static double g_bench_budget = 0.0;      // --bench-budget, ms (0: one frame)
+static double g_bench_threshold = 10.0;  // --bench-threshold, percent
+static PerfLog g_perf;
+
+// Every frame is split into profiler zones, timed on the CPU and the GPU:
+// "frame" around the lot, and inside it the passes "clear", "cull",
+// "animate", "draw", "overlay", "save" (--frames-out) and "swap".
+// "--profile" (or the P key) shows the last PROF_HISTORY frames as a graph
+// and prints a table on exit; "--profile-csv file.csv" logs every frame's
+// zones.
+static Profiler g_prof;
+static bool g_profile = false;        // --profile
+static bool g_profile_graph = false;  // P key
+// The zones the GPU does real work in. Their GPU times add up to the
+// frame's; zones that only run CPU code measure the gap before the
+// GPU hears from us again.
+static const char* k_gpu_passes[] = {"clear", "draw", "overlay"};
+#define GPU_PASSES ((int)(sizeof(k_gpu_passes) / sizeof(k_gpu_passes[0])))
+
+// Graph layout, bottom-right: a stacked bar of each frame's zone CPU
+// times with a white tick at its GPU time, a grey line at 60 Hz, then the
+// rolling averages: CPU, and GPU per pass
+#define GRAPH_PX_PER_FRAME 2
+#define GRAPH_BOTTOM 10.0f  // Pixels above the framebuffer's bottom edge
+#define GRAPH_HEIGHT 100
+#define GRAPH_MS 33.3f  // Full height
+#define GRAPH_MAX_QUADS (2 + PROF_HISTORY * (PROF_MAX_ZONES + 1) + \
+                         2 * PROF_MAX_ZONES)
+#define GRAPH_BYTES (sizeof(float) * 5 * 6 * GRAPH_MAX_QUADS)
+static unsigned int g_graph_program;
+static unsigned int g_graph_vao;
+static size_t g_graph_at;  // This frame's vertices in the stream
+
+// "--cube-sweep" steps through these counts and prints the frame time of
+// each, with vsync off so the numbers are the real cost
+static const int k_sweep_counts[] = {10, 100, 1000, 10000, 100000, 1000000};
+#define SWEEP_WARMUP 10   // Frames skipped after each change
+#define SWEEP_FRAMES 60   // Frames measured per count
+
+// What one frame cost besides its frame time
+typedef struct {
+  double anim;      // CPU time spent culling, animating and uploading
+  double cull;      // The culling part of that
+  double stall;     // Waiting for the GPU to free this frame's upload region
+  double drawn;     // Cubes that survived culling
+  double uploaded;  // Bytes streamed to the GPU
+} FrameCost;
+
+typedef struct {
+  double sum;  // Frame time, swap to swap
+  double max;
+  FrameCost cost;  // Summed
+  int n;
+} FrameStats;
+
+static void frame_stats_add(FrameStats* s, double dt, const FrameCost* c) {
+  s->sum += dt;
+  if (dt > s->max) s->max = dt;
+  s->cost.anim += c->anim;
+  s->cost.cull += c->cull;
+  s->cost.stall += c->stall;
+  s->cost.drawn += c->drawn;
+  s->cost.uploaded += c->uploaded;
+  s->n++;
+}
+
+// Wall-clock seconds, for measuring what things cost
+static double visual_clock(void) {
+  return g_headless ? (double)netclock_mono_ns() * 1e-9 : glfwGetTime();
+}
+
+// Show time of frame n: the wall clock, or simulated when headless or
+// benchmarking
+static double visual_show_time(long long n) {
+  bool simulated = g_headless || g_bench_out;
+  return simulated ? (double)n / g_headless_fps : glfwGetTime();
+}
+
+static bool visual_closing(GLFWwindow* window) {
+  return window ? glfwWindowShouldClose(window) : g_quit;
+}
+
+static void visual_close(GLFWwindow* window) {
+  if (window) {
+    glfwSetWindowShouldClose(window, true);
+  } else {
+    g_quit = true;
+  }
+}
+
+// Read back the frame just drawn and write it to DIR/frame_NNNNN.ppm
+static bool visual_save_frame(const char* dir, long long n) {
+  int w = g_fb_width, h = g_fb_height;
+  unsigned char* rgba = (unsigned char*)malloc((size_t)w * h * 4);
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/frame_%05lld.ppm", dir, n);
+  FILE* out = rgba ? fopen(path, "wb") : NULL;
+  if (!out) {
+    free(rgba);
+    return false;
+  }
+  glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+  // GL's rows run bottom-up, PPM's top-down
+  fprintf(out, "P6\n%d %d\n255\n", w, h);
+  bool ok = true;
+  for (int y = h - 1; y >= 0 && ok; y--) {
+    const unsigned char* row = rgba + (size_t)y * w * 4;
+    for (int x = 0; x < w; x++) ok = fwrite(row + 4 * x, 1, 3, out) == 3;
+  }
+  ok = fclose(out) == 0 && ok;
+  free(rgba);
+  return ok;
+}
+
+// The camera `t` seconds into the bench script, between keyframes
+static void bench_view(double t, mat4 view) {
+  int k = 0;
+  while (k + 2 < BENCH_KEYS && t >= k_bench_path[k + 1].at) k++;
+  const BenchKey* a = &k_bench_path[k];
+  const BenchKey* b = &k_bench_path[k + 1];
+  float u = (float)((t - a->at) / (b->at - a->at));
+  u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+  float yaw = a->yaw + (b->yaw - a->yaw) * u;
+  float z = a->z + (b->z - a->z) * u;
+  glm_mat4_identity(view);
+  glm_rotate(view, glm_rad(-yaw), (vec3){0.0f, 1.0f, 0.0f});
+  glm_translate(view, (vec3){0.0f, 0.0f, -z});
+}
+
+// GPU time of the frame read back `ago` frames before the latest
+static double visual_gpu_ms(int ago) {
+  double ms = 0.0;
+  for (int k = 0; k < GPU_PASSES; k++) {
+    ms += prof_ms(&g_prof, prof_zone(&g_prof, k_gpu_passes[k]), ago, true);
+  }
+  return ms;
+}
+
+// What's holding frames back, going by the rolling averages: the GPU
+// passes, the CPU's own work, or waiting in swap (vsync, or a full queue)
+static const char* visual_bound(void) {
+  double gpu = 0.0;
+  for (int k = 0; k < GPU_PASSES; k++) {
+    gpu += prof_average(&g_prof, prof_zone(&g_prof, k_gpu_passes[k]), true);
+  }
+  double swap = prof_average(&g_prof, prof_zone(&g_prof, "swap"), false);
+  double cpu =
+      prof_average(&g_prof, prof_zone(&g_prof, "frame"), false) - swap;
+  if (gpu >= cpu) return "GPU";
+  return swap > cpu ? "swap" : "CPU";
+}
+
+// A frame has been read back from the profiler: its GPU time, if benching
+static void bench_frame_done(long long frame) {
+  if (g_bench_out && frame >= g_bench_warmup) {
+    perf_add(&g_perf, PERF_GPU, visual_gpu_ms(0));
+  }
+}
+
+// Print and save the results. Returns the exit status: 1 if the report
+// couldn't be written or the baseline check failed.
+static int bench_finish(void) {
+  static const char* names[PERF_SERIES] = {"frame", "cpu", "gpu"};
+  printf("Bench: %d frames after %d warmup, %d over the %.2f ms budget\n",
+         g_perf.count[PERF_FRAME], g_bench_warmup, g_perf.over_budget,
+         g_perf.budget_ms);
+  printf("  %-6s %9s %9s %9s %9s\n", "ms", "p50", "p95", "p99", "max");
+  for (int s = 0; s < PERF_SERIES; s++) {
+    PerfSummary sum;
+    perf_summary(&g_perf, (PerfSeries)s, &sum);
+    printf("  %-6s %9.3f %9.3f %9.3f %9.3f\n", names[s], sum.p50, sum.p95,
+           sum.p99, sum.max);
+  }
+
+  char setup[256];
+  snprintf(setup, sizeof(setup),
+           "%s, %dx%d, %d cubes, %s animation, culling %s, %d thread(s), "
+           "%.0f fps",
+           (const char*)glGetString(GL_RENDERER), g_fb_width, g_fb_height,
+           g_cubes.count, k_anim_names[g_anim], g_cull ? "on" : "off",
+           g_worker_threads, g_headless_fps);
+  int status = 0;
+  if (perf_write_json(&g_perf, g_bench_out, setup)) {
+    printf("Bench report written to %s\n", g_bench_out);
+  } else {
+    printf("Failed to write %s\n", g_bench_out);
+    status = 1;
+  }
+  if (g_bench_baseline) {
+    int regressed =
+        perf_compare(&g_perf, g_bench_baseline, g_bench_threshold);
+    if (regressed < 0) {
+      printf("Failed to read baseline %s\n", g_bench_baseline);
+      status = 1;
+    } else if (regressed > 0) {
+      printf("%d timing(s) regressed\n", regressed);
+      status = 1;
+    }
+  }
+  perf_free(&g_perf);
+  return status;
+}
+
+// Worst case per frame through the stream: the frame block, then either
+// every cube's matrix or every cube's index, then the profile graph's
+// vertices, with alignment slack for each
+static size_t visual_stream_bytes(int count) {
+  return sizeof(FrameBlock) + 3 * (size_t)g_ubo_align +
+         sizeof(float) * 16 * (size_t)count + GRAPH_BYTES;
+}
+
+// Box chunk c's centres, then a sphere around the box and the cubes' own
+static void visual_chunk_bounds(int c) {
+  int begin = c * TRANSFORM_CHUNK;
+  int end = g_cubes.count - begin > TRANSFORM_CHUNK ? begin + TRANSFORM_CHUNK
+                                                    : g_cubes.count;
+  float lo[3] = {g_cubes.x[begin], g_cubes.y[begin], g_cubes.z[begin]};
+  float hi[3] = {lo[0], lo[1], lo[2]};
+  for (int i = begin + 1; i < end; i++) {
+    float p[3] = {g_cubes.x[i], g_cubes.y[i], g_cubes.z[i]};
+    for (int a = 0; a < 3; a++) {
+      if (p[a] < lo[a]) lo[a] = p[a];
+      if (p[a] > hi[a]) hi[a] = p[a];
+    }
+  }
+  float* b = g_chunk_bounds + 4 * (size_t)c;
+  float r2 = 0.0f;
+  for (int a = 0; a < 3; a++) {
+    b[a] = 0.5f * (lo[a] + hi[a]);
+    r2 += 0.25f * (hi[a] - lo[a]) * (hi[a] - lo[a]);
+  }
+  b[3] = sqrtf(r2) + CUBE_RADIUS;
+}
+
+// Lay the field out for a new cube count and size the instance buffer to
+// match. Keeps the current field if the new one can't be allocated.
+static bool visual_set_cubes(int count) {
+  CubeField f;
+  TransformSet xf;
+  if (!cubes_init(&f, count)) return false;
+  size_t chunks = ((size_t)count + TRANSFORM_CHUNK - 1) / TRANSFORM_CHUNK;
+  float* inst = (float*)malloc(sizeof(float) * 16 * (size_t)count);
+  uint32_t* visible = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)count);
+  int* found = (int*)calloc(chunks, sizeof(int));
+  int* offset = (int*)calloc(chunks, sizeof(int));
+  float* bounds = (float*)malloc(sizeof(float) * 4 * chunks);
+  if (!inst || !visible || !found || !offset || !bounds ||
+      !transforms_init(&xf, count) ||
+      !stream_reserve(&g_stream, visual_stream_bytes(count))) {
+    free(inst);
+    free(visible);
+    free(found);
+    free(offset);
+    free(bounds);
+    transforms_free(&xf);
+    cubes_free(&f);
+    // A failed reserve leaves the ring empty: size it for the old field
+    if (g_cubes.count > 0) {
+      stream_reserve(&g_stream, visual_stream_bytes(g_cubes.count));
+    }
+    return false;
+  }
+  cubes_place(&f, &xf);
+  cubes_free(&g_cubes);
+  transforms_free(&g_xforms);
+  free(g_instances);
+  free(g_visible);
+  free(g_chunk_found);
+  free(g_chunk_offset);
+  free(g_chunk_bounds);
+  g_cubes = f;
+  g_xforms = xf;
+  g_instances = inst;
+  g_visible = visible;
+  g_chunk_found = found;
+  g_chunk_offset = offset;
+  g_chunk_bounds = bounds;
+  for (size_t c = 0; c < chunks; c++) visual_chunk_bounds((int)c);
+
+  // The GPU path's static data, two texels per cube: (centre, phase) and
+  // (axis, 0). Packed in the instance array, which is big enough.
+  for (int i = 0; i < count; i++) {
+    float* t = inst + 8 * (size_t)i;
+    t[0] = f.x[i];
+    t[1] = f.y[i];
+    t[2] = f.z[i];
+    t[3] = f.phase[i];
+    t[4] = f.ax[i];
+    t[5] = f.ay[i];
+    t[6] = f.az[i];
+    t[7] = 0.0f;
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, g_cube_buf);
+  glBufferData(GL_TEXTURE_BUFFER, sizeof(float) * 8 * (size_t)count, inst,
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  return true;
+}
+
+// Point the per-instance attributes at this frame's data in the stream
+// (the VAO must be bound), or switch off the ones the program won't read
+static void visual_instance_attribs(bool matrices, size_t matrix_at,
+                                    bool indices, size_t index_at) {
+  glBindBuffer(GL_ARRAY_BUFFER, g_stream.buffer);
+  for (int c = 0; c < 4; c++) {
+    if (matrices) {
+      glVertexAttribPointer(
+          CUBE_ATTRIB + c, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
+          (void*)(matrix_at + (size_t)c * 4 * sizeof(float)));
+      glEnableVertexAttribArray(CUBE_ATTRIB + c);
+    } else {
+      glDisableVertexAttribArray(CUBE_ATTRIB + c);
+    }
+  }
+  if (indices) {
+    glVertexAttribIPointer(INDEX_ATTRIB, 1, GL_UNSIGNED_INT,
+                           sizeof(uint32_t), (void*)index_at);
+    glEnableVertexAttribArray(INDEX_ATTRIB);
+  } else {
+    glDisableVertexAttribArray(INDEX_ATTRIB);
+  }
+}
+
+// Culling worker job: one chunk's visible cubes, compacted in place
+static void visual_cull_job(void* ctx, int begin, int end) {
+  g_chunk_found[begin / TRANSFORM_CHUNK] =
+      cull_spheres((const Frustum*)ctx, g_cubes.x, g_cubes.y, g_cubes.z,
+                   CUBE_RADIUS, begin, end, g_visible + begin);
+}
+
+// Where each chunk's visible cubes go in the packed draw: chunks sorted by
+// the distance to their nearest point (the camera looks down -z), keyed
+// like the render queue's depth, so hidden cubes mostly fail the depth test
+// before shading. Returns the total.
+static int visual_pack_chunks(mat4 view) {
+  static uint64_t keys[CHUNKS_MAX], key_tmp[CHUNKS_MAX];
+  static uint32_t order[CHUNKS_MAX], order_tmp[CHUNKS_MAX];
+  int chunks = (g_cubes.count + TRANSFORM_CHUNK - 1) / TRANSFORM_CHUNK;
+  int n = 0;
+  for (int c = 0; c < chunks; c++) {
+    if (g_chunk_found[c] == 0) continue;
+    const float* b = g_chunk_bounds + 4 * (size_t)c;
+    float z = view[0][2] * b[0] + view[1][2] * b[1] + view[2][2] * b[2] +
+              view[3][2];
+    float depth = -z - b[3];
+    uint32_t bits = 0;  // Non-negative floats sort as their bits
+    if (depth > 0.0f) memcpy(&bits, &depth, sizeof(bits));
+    keys[n] = bits;
+    order[n++] = (uint32_t)c;
+  }
+  radix_sort(keys, order, n, key_tmp, order_tmp);
+  int total = 0;
+  for (int k = 0; k < n; k++) {
+    g_chunk_offset[order[k]] = total;
+    total += g_chunk_found[order[k]];
+  }
+  return total;
+}
 
-// Generate frequencies for a Minor Pentatonic scale
-static double get_funky_bass_note(int k) {
-  static const int st[] = {0, 3, 5, 7, 10};
-  int scale_idx = k % 5;
-  int octave = (k / 5) % 2;
-  double base = 55.0 * pow(2.0, octave);
-  return base * pow(2.0, st[scale_idx] / 12.0);
+// ANIM_GPU worker job: one chunk's visible list into the mapped index buffer
+static void visual_index_job(void* ctx, int begin, int end) {
+  (void)end;
+  int c = begin / TRANSFORM_CHUNK;
+  memcpy((uint32_t*)ctx + g_chunk_offset[c], g_visible + begin,
+         sizeof(uint32_t) * (size_t)g_chunk_found[c]);
+}
+
+// ANIM_SIMD worker job: rotations, then matrices, for one chunk of cubes
+// (packed, and only the visible ones, when culling)
+typedef struct {
+  float turn;
+  float* out;  // This frame's matrices in the stream
+} TransformJob;
+
+static void visual_transform_job(void* ctx, int begin, int end) {
+  TransformJob* job = (TransformJob*)ctx;
+  int c = begin / TRANSFORM_CHUNK;
+  if (g_cull && g_chunk_found[c] == 0) return;
+  cubes_spin(&g_cubes, job->turn, begin, end, &g_xforms);
+  if (g_cull) {
+    transforms_write_list(&g_xforms, g_visible + begin, g_chunk_found[c],
+                          job->out + 16 * (size_t)g_chunk_offset[c]);
+  } else {
+    transforms_write(&g_xforms, begin, end, job->out);
+  }
+}
+
+// The drawn cubes as a queued draw: every one in a single instanced call,
+// with the packet's item as the instance count
+typedef struct {
+  bool matrices;  // CPU and SIMD paths; otherwise the GPU path
+  size_t at;      // Matrices or visible indices in the stream
+  float turn;
+  GLint turn_loc;  // ANIM_GPU's uniforms
+  GLint culled_loc;
+} CubeDraw;
+
+static void visual_draw_cubes(void* ctx, int count) {
+  const CubeDraw* d = (const CubeDraw*)ctx;
+  if (d->matrices) {
+    visual_instance_attribs(true, d->at, false, 0);
+  } else {
+    glUniform1f(d->turn_loc, d->turn);
+    glUniform1i(d->culled_loc, g_cull);
+    visual_instance_attribs(false, 0, g_cull, d->at);
+  }
+  glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, count);
+}
+
+// Can this many cubes go through the buffer texture?
+static bool visual_gpu_fits(int count) {
+  return 2LL * count <= g_cube_tex_max;
+}
+
+// Compile and link a vertex + fragment shader pair, printing any errors
+static unsigned int link_program(const char* vs_src, const char* fs_src) {
+  int success;
+  char infoLog[512];
+  unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(vs, 1, &vs_src, NULL);
+  glCompileShader(vs);
+  glGetShaderiv(vs, GL_COMPILE_STATUS, &success);
+  if (!success) {
+    glGetShaderInfoLog(vs, 512, NULL, infoLog);
+    printf("ERROR::SHADER::VERTEX::COMPILATION_FAILED\n%s\n", infoLog);
+  }
+
+  unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(fs, 1, &fs_src, NULL);
+  glCompileShader(fs);
+  glGetShaderiv(fs, GL_COMPILE_STATUS, &success);
+  if (!success) {
+    glGetShaderInfoLog(fs, 512, NULL, infoLog);
+    printf("ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n%s\n", infoLog);
+  }
+
+  unsigned int program = glCreateProgram();
+  glAttachShader(program, vs);
+  glAttachShader(program, fs);
+  glLinkProgram(program);
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    glGetProgramInfoLog(program, 512, NULL, infoLog);
+    printf("ERROR::SHADER::PROGRAM::LINKING_FAILED\n%s\n", infoLog);
+  }
+
+  // Every program reads the per-frame block from the same binding
+  unsigned int block = glGetUniformBlockIndex(program, "Frame");
+  if (block != GL_INVALID_INDEX) {
+    glUniformBlockBinding(program, block, FRAME_BINDING);
+  }
+
+  glDeleteShader(vs);
+  glDeleteShader(fs);
+  return program;
 }
 
 void processInput(GLFWwindow* window);
+void draw_meters(const MeterReading* m);
+void queue_profile(void);
+void draw_profile_graph(void* ctx, int vertices);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
-int main() {
-  // 1. Initialize Audio System
-  if (!audio_init()) {
-    printf("Audio Init Failed\n");
-    return -1;
+// "--rate", "--device-rate" and "--channels" each take a number
+static bool audio_format_flag(const char* arg) {
+  return strcmp(arg, "--rate") == 0 || strcmp(arg, "--device-rate") == 0 ||
+         strcmp(arg, "--channels") == 0;
+}
+
+// "--osc PORT" and "--osc-bind ADDR" configure the control surface;
+// "--lead PORT" and "--follow HOST:PORT" the shared timeline
+static bool control_flag(const char* arg) {
+  return strcmp(arg, "--osc") == 0 || strcmp(arg, "--osc-bind") == 0 ||
+         strcmp(arg, "--lead") == 0 || strcmp(arg, "--follow") == 0;
+}
+
+// "--cubes N" sets how many cubes are drawn, "--anim cpu|gpu|simd" where
+// their motion is computed, "--threads N" how many threads the SIMD path and
+// culling use, "--cull on|off" whether cubes off screen are skipped,
+// "--stream persistent|unsync" how per-frame data is mapped; "--headless
+// WxH", "--fps N", "--frames N", "--frames-out DIR" and "--profile-csv
+// FILE" as above
+static bool visual_flag(const char* arg) {
+  return strcmp(arg, "--cubes") == 0 || strcmp(arg, "--anim") == 0 ||
+         strcmp(arg, "--threads") == 0 || strcmp(arg, "--cull") == 0 ||
+         strcmp(arg, "--stream") == 0 || strcmp(arg, "--headless") == 0 ||
+         strcmp(arg, "--fps") == 0 || strcmp(arg, "--frames") == 0 ||
+         strcmp(arg, "--frames-out") == 0 ||
+         strcmp(arg, "--profile-csv") == 0;
+}
+
+// "--bench report.json" and its "--bench-warmup N", "--bench-budget MS",
+// "--bench-baseline old.json" and "--bench-threshold PCT"
+static bool bench_flag(const char* arg) {
+  return strcmp(arg, "--bench") == 0 || strcmp(arg, "--bench-warmup") == 0 ||
+         strcmp(arg, "--bench-budget") == 0 ||
+         strcmp(arg, "--bench-baseline") == 0 ||
+         strcmp(arg, "--bench-threshold") == 0;
+}
+
+// Join (or lead) the shared timeline, or run on a local one
+static void control_clock_open(int lead_port, const char* follow) {
+  if (lead_port >= 0) {
+    if (netclock_lead(&g_clock, "0.0.0.0", lead_port, SEQ_TEMPO)) {
+      printf("Leading the show clock on port %d\n", g_clock.port);
+    } else {
+      printf("Failed to open clock port %d, running alone\n", lead_port);
+    }
+    return;
+  }
+  if (follow) {
+    char host[64];
+    const char* colon = strrchr(follow, ':');
+    size_t len = colon ? (size_t)(colon - follow) : 0;
+    if (colon && len < sizeof(host)) {
+      memcpy(host, follow, len);
+      host[len] = '\0';
+      if (netclock_follow(&g_clock, host, atoi(colon + 1), NULL)) {
+        printf("Following the show clock at %s\n", follow);
+        return;
+      }
+    }
+    printf("Failed to follow %s (want HOST:PORT), running alone\n", follow);
   }
+  netclock_solo(&g_clock, SEQ_TEMPO);
+}
 
-  // 2. Initialize Windowing System (GLFW)
-  if (!glfwInit()) {
-    printf("Failed to initialoze GLFW\n");
+int main(int argc, char** argv) {
+  bool realtime = false;
+  bool device_rate_set = false;
+  int osc_port = -1;
+  const char* osc_host = "127.0.0.1";  // Loopback unless asked otherwise
+  int lead_port = -1;
+  const char* follow = NULL;
+  bool sweep = false;
+  bool cubes_set = false;
+  const char* profile_csv = NULL;
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--realtime") == 0) realtime = true;
+    if (strcmp(argv[a], "--profile") == 0) g_profile = true;
+    if (strcmp(argv[a], "--profile-csv") == 0 && a + 1 < argc) {
+      profile_csv = argv[a + 1];
+    }
+    if (strcmp(argv[a], "--cube-sweep") == 0) sweep = true;
+    if (strcmp(argv[a], "--cubes") == 0 && a + 1 < argc) {
+      g_cube_target = atoi(argv[a + 1]);
+      cubes_set = true;
+    }
+    if (strcmp(argv[a], "--anim") == 0 && a + 1 < argc) {
+      for (int m = 0; m < ANIM_MODES; m++) {
+        if (strcmp(argv[a + 1], k_anim_names[m]) == 0) g_anim = (AnimMode)m;
+      }
+    }
+    if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+      g_worker_threads = atoi(argv[a + 1]);
+    }
+    if (strcmp(argv[a], "--cull") == 0 && a + 1 < argc) {
+      g_cull = strcmp(argv[a + 1], "off") != 0;
+    }
+    if (strcmp(argv[a], "--stream") == 0 && a + 1 < argc) {
+      g_stream_persistent = strcmp(argv[a + 1], "unsync") != 0;
+    }
+    if (strcmp(argv[a], "--headless") == 0 && a + 1 < argc) {
+      g_headless = true;
+      if (sscanf(argv[a + 1], "%dx%d", &g_headless_width,
+                 &g_headless_height) != 2 ||
+          g_headless_width < 1 || g_headless_height < 1) {
+        printf("--headless wants WIDTHxHEIGHT, using 1280x720\n");
+        g_headless_width = 1280;
+        g_headless_height = 720;
+      }
+    }
+    if (strcmp(argv[a], "--fps") == 0 && a + 1 < argc) {
+      g_headless_fps = atof(argv[a + 1]);
+      if (g_headless_fps <= 0.0) g_headless_fps = 60.0;
+    }
+    if (strcmp(argv[a], "--frames") == 0 && a + 1 < argc) {
+      g_frame_limit = atoll(argv[a + 1]);
+    }
+    if (strcmp(argv[a], "--frames-out") == 0 && a + 1 < argc) {
+      g_frames_out = argv[a + 1];
+    }
+    if (bench_flag(argv[a]) && a + 1 < argc) {
+      const char* v = argv[a + 1];
+      if (strcmp(argv[a], "--bench") == 0) {
+        g_bench_out = v;
+      } else if (strcmp(argv[a], "--bench-warmup") == 0) {
+        g_bench_warmup = atoi(v) > 0 ? atoi(v) : 0;
+      } else if (strcmp(argv[a], "--bench-budget") == 0) {
+        g_bench_budget = atof(v);
+      } else if (strcmp(argv[a], "--bench-baseline") == 0) {
+        g_bench_baseline = v;
+      } else {
+        g_bench_threshold = atof(v);
+      }
+    }
+    if (strcmp(argv[a], "--osc") == 0 && a + 1 < argc) {
+      osc_port = atoi(argv[a + 1]);
+    } else if (strcmp(argv[a], "--osc-bind") == 0 && a + 1 < argc) {
+      osc_host = argv[a + 1];
+    } else if (strcmp(argv[a], "--lead") == 0 && a + 1 < argc) {
+      lead_port = atoi(argv[a + 1]);
+    } else if (strcmp(argv[a], "--follow") == 0 && a + 1 < argc) {
+      follow = argv[a + 1];
+    }
+    if (!audio_format_flag(argv[a]) || a + 1 >= argc) continue;
+    int v = atoi(argv[a + 1]);
+    if (strcmp(argv[a], "--rate") == 0) {
+      g_engine_rate = v;
+    } else if (strcmp(argv[a], "--device-rate") == 0) {
+      g_device_rate = v;
+      device_rate_set = true;
+    } else {
+      g_channels = v;
+    }
+  }
+  // The device follows the engine unless told otherwise
+  if (!device_rate_set) g_device_rate = g_engine_rate;
+  if (g_engine_rate < 8000 || g_engine_rate > AUDIO_MAX_RATE ||
+      g_device_rate < 8000 || g_device_rate > AUDIO_MAX_RATE ||
+      g_channels < 1 || g_channels > AUDIO_MAX_CHANNELS) {
+    printf("Unsupported audio format: %d Hz engine, %d Hz device, %d ch\n",
+           g_engine_rate, g_device_rate, g_channels);
     return -1;
   }
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-
-  GLFWwindow* window = glfwCreateWindow(1280, 720, "C Demo Engine", NULL, NULL);
+  long long bench_frames = 0;
+  if (g_bench_out && sweep) {
+    printf("--cube-sweep and --bench don't mix, sweeping\n");
+    g_bench_out = NULL;
+  }
+  if (g_bench_out) {
+    if (!cubes_set) g_cube_target = BENCH_CUBES;
+    bench_frames = llround(k_bench_path[BENCH_KEYS - 1].at * g_headless_fps);
+    if (g_bench_budget <= 0.0) g_bench_budget = 1000.0 / g_headless_fps;
+    if (!perf_init(&g_perf, (int)bench_frames + 1, g_bench_budget)) {
+      printf("Failed to allocate the bench log\n");
+      return -1;
+    }
+  }
+  if (g_cube_target < 1 || g_cube_target > CUBES_MAX) {
+    printf("--cubes wants 1 to %d, using %d\n", CUBES_MAX, CUBES_DEFAULT);
+    g_cube_target = CUBES_DEFAULT;
+  }
+  // SIMD transform workers: one per core by default, the render thread
+  // being one of them
+  if (g_worker_threads <= 0) {
+    g_worker_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  g_worker_threads = workers_start(&g_workers, g_worker_threads);
+
+  // "--record show.wav" captures the output; a ".raw" name gets float32
+  for (int a = 1; a + 1 < argc; a++) {
+    if (strcmp(argv[a], "--record") != 0) continue;
+    const char* path = argv[a + 1];
+    size_t len = strlen(path);
+    RecordFormat fmt = len > 4 && strcmp(path + len - 4, ".raw") == 0
+                           ? RECORD_RAW_F32
+                           : RECORD_WAV_S16;
+    g_recording = recorder_open(&g_rec, path, fmt, g_device_rate, g_channels);
+    if (!g_recording) printf("Failed to open recording %s\n", path);
+  }
 
-  if (window == NULL) {
-    printf("Failed to create GLFW window\n");
-    glfwTerminate();
+  // 1. Initialize Audio System
+  if (!audio_init(realtime)) {
+    printf("Audio Init Failed\n");
     return -1;
   }
+  if (realtime) {
+    rt_print_report(&g_rt_report, 1.0);
+  }
+  printf("Audio: %d Hz engine, %d Hz device, %d channel(s)%s\n",
+         g_engine_rate, g_device_rate, g_channels,
+         g_engine_rate != g_device_rate ? " (resampling)" : "");
+  printf("Audio output latency: %.1f ms (incl. %.1f ms limiter look-ahead)\n",
+         audio_output_latency() * 1000.0,
+         dynamics_latency(&g_dyn) * 1000.0 / g_engine_rate);
+
+  // Map any WAVs given on the command line. "--loop file.wav" plays the file
+  // as a continuous loop, plain paths become one-shots fired on the downbeat.
+  int one_shots[SAMPLER_MAX_SAMPLES];
+  int num_one_shots = 0;
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--realtime") == 0 ||
+        strcmp(argv[a], "--cube-sweep") == 0 ||
+        strcmp(argv[a], "--profile") == 0)
+      continue;
+    if (strcmp(argv[a], "--record") == 0 || audio_format_flag(argv[a]) ||
+        control_flag(argv[a]) || visual_flag(argv[a]) ||
+        bench_flag(argv[a])) {
+      a++;
+      continue;
+    }
+    bool loop = strcmp(argv[a], "--loop") == 0 && a + 1 < argc;
+    if (loop) a++;
+    int id = sampler_load(&g_sampler, argv[a], loop);
+    if (id < 0) {
+      printf("Failed to map sample %s\n", argv[a]);
+    } else if (loop) {
+      audio_sample(id, 0.5, 0);  // Sample 0 is long gone: starts at once
+    } else {
+      one_shots[num_one_shots++] = id;
+    }
+  }
+  if (!sampler_start_prefetch(&g_sampler)) {
+    printf("Failed to start sample prefetch thread\n");
+  }
+  if (osc_port >= 0 && !control_osc_open(osc_host, osc_port)) {
+    printf("Failed to open OSC port %s:%d\n", osc_host, osc_port);
+  }
+  control_clock_open(lead_port, follow);
+
+  // 2. Initialize Windowing System (GLFW), or an offscreen context
+  GLFWwindow* window = NULL;
+  GLADloadproc gl_proc = (GLADloadproc)glfwGetProcAddress;
+#ifdef HAVE_EGL
+  Headless offscreen;
+#endif
+  if (g_headless) {
+#ifdef HAVE_EGL
+    // Loads GLAD itself and leaves its framebuffer bound
+    if (!headless_open(&offscreen, g_headless_width, g_headless_height)) {
+      printf("Failed to create a headless GL context\n");
+      return -1;
+    }
+    gl_proc = (GLADloadproc)headless_proc_address;
+    g_fb_width = g_headless_width;
+    g_fb_height = g_headless_height;
+#else
+    printf("--headless needs a build with EGL\n");
+    return -1;
+#endif
+  } else {
+    if (!glfwInit()) {
+      printf("Failed to initialoze GLFW\n");
+      return -1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
-  glfwMakeContextCurrent(window);
+    window = glfwCreateWindow(1280, 720, "C Demo Engine", NULL, NULL);
 
-  // 3. Initialize OpenGL Loader (GLAD)
-  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-    printf("Failed to initialize GLAD\n");
-    return -1;
-  }
+    if (window == NULL) {
+      printf("Failed to create GLFW window\n");
+      glfwTerminate();
+      return -1;
+    }
+
+    glfwMakeContextCurrent(window);
 
-  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    // 3. Initialize OpenGL Loader (GLAD)
+    if (!gladLoadGLLoader(gl_proc)) {
+      printf("Failed to initialize GLAD\n");
+      return -1;
+    }
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwGetFramebufferSize(window, &g_fb_width, &g_fb_height);
+    if (sweep || g_bench_out) glfwSwapInterval(0);
+  }
   glEnable(GL_DEPTH_TEST);
 
   // Flip textures because OpenGL expects 0.0 on Y axis at bottom
@@ -290,22 +1586,53 @@ int main() {
                         (void*)(6 * sizeof(float)));
   glEnableVertexAttribArray(2);
 
+  // Per-instance data: a model matrix (a mat4 takes four attribute slots)
+  // or, for GPU animation with culling, a cube index read as an integer.
+  // Each advances once per instance instead of once per vertex, and is
+  // pointed at this frame's part of the stream before drawing.
+  for (int c = 0; c < 4; c++) glVertexAttribDivisor(CUBE_ATTRIB + c, 1);
+  glVertexAttribDivisor(INDEX_ATTRIB, 1);
+
   glBindVertexArray(0);
 
+  // Static cube data for GPU animation, fetched by instance ID
+  glGenBuffers(1, &g_cube_buf);
+  glBindBuffer(GL_TEXTURE_BUFFER, g_cube_buf);  // Creates the buffer object
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  glGenTextures(1, &g_cube_tex);
+  glBindTexture(GL_TEXTURE_BUFFER, g_cube_tex);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, g_cube_buf);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &g_cube_tex_max);
+
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &g_ubo_align);
+  stream_init(&g_stream, g_stream_persistent, gl_proc);
+  printf("Per-frame uploads: %s\n",
+         g_stream.persistent ? "persistently mapped ring"
+                             : "unsynchronized mapped ring");
+  if (!rq_init(&g_queue, 64)) {
+    printf("Failed to allocate the render queue\n");
+    return -1;
+  }
+
+  if (!visual_set_cubes(sweep ? k_sweep_counts[0] : g_cube_target)) {
+    printf("Failed to allocate %d cubes\n", g_cube_target);
+    return -1;
+  }
+  g_cube_target = g_cubes.count;
+
   // --- SHADER SETUP ---
   const char* vertexShaderSource =
       "#version 330 core\n"
       "layout (location = 0) in vec3 aPos;\n"
       "layout (location = 1) in vec3 aColor;\n"
       "layout (location = 2) in vec2 aTextCoord;\n"
-      "uniform mat4 model;\n"
-      "uniform mat4 view;\n"
-      "uniform mat4 projection;\n"
+      "layout (location = 3) in mat4 aModel;\n" FRAME_BLOCK_GLSL
       "out vec3 ourColor;\n"
       "out vec2 TextCoord;\n"
       "void main()\n"
       "{\n"
-      "   gl_Position = projection* view * model "
+      "   gl_Position = projection* view * aModel "
       "* vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
       "   ourColor = aColor;\n"
       "   TextCoord = aTextCoord;\n"
@@ -322,123 +1649,656 @@ int main() {
       "   FragColor = texture(ourTexture, TextCoord);\n "
       "}\n\0";
 
-  // Compile Vertex Shader
-  unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-  glCompileShader(vertexShader);
+  // GPU animation: centre, phase and axis come from the buffer texture at
+  // this instance's cube index (its place in the visible list when culling,
+  // else the instance ID), and the rotation (Rodrigues' formula, the same
+  // one glm_rotate uses) is applied right here. `turn` is time * spin in
+  // degrees, wrapped on the CPU in double precision.
+  const char* gpuVertexShaderSource =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in vec3 aColor;\n"
+      "layout (location = 2) in vec2 aTextCoord;\n"
+      "layout (location = 7) in uint aCube;\n"
+      "uniform samplerBuffer cubes;\n"
+      "uniform bool culled;\n"
+      "uniform float turn;\n" FRAME_BLOCK_GLSL
+      "out vec3 ourColor;\n"
+      "out vec2 TextCoord;\n"
+      "void main()\n"
+      "{\n"
+      "   int id = culled ? int(aCube) : gl_InstanceID;\n"
+      "   vec4 c = texelFetch(cubes, 2 * id);\n"
+      "   vec3 u = texelFetch(cubes, 2 * id + 1).xyz;\n"
+      "   float a = radians(c.w + turn);\n"
+      "   float s = sin(a), k = cos(a);\n"
+      "   vec3 p = aPos * k + cross(u, aPos) * s "
+      "+ u * dot(u, aPos) * (1.0 - k);\n"
+      "   gl_Position = projection * view * vec4(c.xyz + p, 1.0);\n"
+      "   ourColor = aColor;\n"
+      "   TextCoord = aTextCoord;\n"
+      "}\0";
 
-  int success;
-  char infoLog[512];
-  glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-    printf("ERROR::SHADER::VERTEX::COMPILATION_FAILED\n%s\n", infoLog);
-  }
+  unsigned int programs[ANIM_MODES];
+  programs[ANIM_CPU] = link_program(vertexShaderSource, fragmentShaderSource);
+  programs[ANIM_GPU] =
+      link_program(gpuVertexShaderSource, fragmentShaderSource);
+  programs[ANIM_SIMD] = programs[ANIM_CPU];  // Same matrices, made faster
 
-  // Compile Fragment Shader
-  unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-  glCompileShader(fragmentShader);
-  glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-    printf("ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n%s\n", infoLog);
+  // Profiler graph: flat-coloured quads in pixels, streamed every frame
+  const char* graphVertexShaderSource =
+      "#version 330 core\n"
+      "layout (location = 0) in vec2 aPos;\n"
+      "layout (location = 1) in vec3 aColor;\n" FRAME_BLOCK_GLSL
+      "out vec3 ourColor;\n"
+      "void main()\n"
+      "{\n"
+      "   gl_Position = vec4(aPos / resolution * 2.0 - 1.0, 0.0, 1.0);\n"
+      "   ourColor = aColor;\n"
+      "}\0";
+  const char* graphFragmentShaderSource =
+      "#version 330 core\n"
+      "in vec3 ourColor;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(ourColor, 1.0);\n"
+      "}\0";
+  g_graph_program =
+      link_program(graphVertexShaderSource, graphFragmentShaderSource);
+  glGenVertexArrays(1, &g_graph_vao);
+  glBindVertexArray(g_graph_vao);
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(VAO);
+  g_profile_graph = g_profile;
+  if (!prof_init(&g_prof, profile_csv)) {
+    printf("Failed to open %s\n", profile_csv);
   }
 
-  // Link Program
-  unsigned int shaderProgram = glCreateProgram();
-  glAttachShader(shaderProgram, vertexShader);
-  glAttachShader(shaderProgram, fragmentShader);
-  glLinkProgram(shaderProgram);
-
-  glDeleteShader(vertexShader);
-  glDeleteShader(fragmentShader);
-
   // Locate Uniforms
-  unsigned int modelLoc = glGetUniformLocation(shaderProgram, "model");
-  unsigned int viewLoc = glGetUniformLocation(shaderProgram, "view");
-  unsigned int projectionLoc =
-      glGetUniformLocation(shaderProgram, "projection");
-
-  // Positions for the spinning cubes
-  vec3 cubePositions[] = {{0.0f, 0.0f, 0.0f},    {2.0f, 5.0f, -15.0f},
-                          {-1.5f, -2.2f, -2.5f}, {-3.8f, -2.0f, -12.3f},
-                          {2.4f, -0.4f, -3.5f},  {-1.7f, 3.0f, -7.5f},
-                          {1.3f, -2.0f, -2.5f},  {1.5f, 2.0f, -2.5f},
-                          {1.5f, 0.2f, -1.5f},   {-1.3f, 1.0f, -1.5f}};
-
-  int last_beat_tick = -1;
+  unsigned int turnLoc = glGetUniformLocation(programs[ANIM_GPU], "turn");
+  unsigned int culledLoc = glGetUniformLocation(programs[ANIM_GPU], "culled");
+  glUseProgram(programs[ANIM_GPU]);
+  glUniform1i(glGetUniformLocation(programs[ANIM_GPU], "cubes"), 1);
+
+  long long next_tick = -1;  // First tick not yet queued
+  bool clock_locked = false;
+  double last_title = 0.0;
+  float spin = 25.0f;  // Degrees per second, /visual/spin
+  float background[3] = {0.2f, 0.3f, 0.3f};
+  double last_frame = visual_clock();
+  long long frame_index = 0;
+  FrameStats title_stats = {0};  // Since the last title update
+  FrameStats sweep_stats = {0};  // Current --cube-sweep step
+  int sweep_step = sweep ? 0 : -1;
+  int sweep_frame = 0;
+
+  // Camera: the view is fixed, the projection follows the framebuffer
+  FrameBlock frame = {0};
+  mat4 view = GLM_MAT4_IDENTITY_INIT;
+  glm_translate(view, (vec3){0.0f, 0.0f, -3.0f});
+  memcpy(frame.view, view, sizeof(frame.view));
+  mat4 projection;
+  mat4 clip;  // projection * view, for culling
+  if (g_bench_out) {
+    printf("Bench: %d cubes, %d warmup + %lld frames at %.0f fps\n",
+           g_cube_target, g_bench_warmup, bench_frames, g_headless_fps);
+  }
+  if (sweep) {
+    printf("Cube sweep (vsync off, %s animation, culling %s, %d "
+           "thread(s)):\n",
+           k_anim_names[g_anim], g_cull ? "on" : "off", g_worker_threads);
+  }
 
   // --- MAIN RENDER LOOP ---
-  while (!glfwWindowShouldClose(window)) {
+  while (!visual_closing(window)) {
     // Check global time
-    double time = glfwGetTime();
+    double time = visual_show_time(frame_index);
+    double frame_start = visual_clock();
+    bench_frame_done(prof_frame_begin(&g_prof, frame_index));
+    prof_begin(&g_prof, "frame");
+
+    // Required: Quit automatically after 60 seconds for the demo (a bench
+    // ends with its script instead)
+    if (time > 60.0 && sweep_step < 0 && !g_bench_out) {
+      visual_close(window);
+    }
 
-    // Required: Quit automatically after 60 seconds for the demo
-    if (time > 60.0) {
-      glfwSetWindowShouldClose(window, true);
+    // Simple "Beat" sequencer (480 BPM 16th notes for fast funk) on the
+    // show timeline. Every tick that will reach the speakers within the
+    // look-ahead is queued now, stamped with its exact engine sample.
+    NetClockEstimate clk;
+    netclock_read(&g_clock, &clk);
+    if (clk.locked && !clock_locked && g_clock.role == NETCLOCK_FOLLOWER) {
+      printf("Show clock locked: offset %+.3f ms, round trip %.0f us\n",
+             clk.offset_ns / 1e6, clk.delay_ns / 1e3);
+    }
+    clock_locked = clk.locked;
+    long long now_ns = netclock_mono_ns();
+    double latency = audio_output_latency();
+    if (clk.locked && audio_clock_ready()) {
+      long long ahead = llround((latency + SEQ_LOOKAHEAD) * 1e9);
+      if (next_tick < 0) {
+        // Start at the first tick the audio can still play on time
+        long long heard = now_ns + llround(latency * 1e9);
+        next_tick = (long long)ceil(netclock_ticks(&clk, heard));
+      }
+      bool ticked = false;
+      long long when;
+      while ((when = netclock_tick_local(&clk, next_tick)) <= now_ns + ahead) {
+        long long tick = next_tick++;
+        long long at = audio_sample_at(when);
+        ticked = true;
+        // Trigger a random note from the Pentatonic Scale
+        if (rand() % 10 > 2) {  // 80% chance to play
+          double note = synth_bass_note(rand() % 15);
+          audio_slap(note, at);  // Safe producer call
+        }
+        // Answer the bass on the off-beats with plucked strings two
+        // octaves up, and strike a bell-like string at the top of every bar
+        if (tick % 2 == 1 && rand() % 2 == 0) {
+          audio_pluck(synth_bass_note(rand() % 15) * 4.0, PLUCK_PLUCKED, at);
+        }
+        if (tick % 16 == 0) {
+          audio_pluck(synth_bass_note(rand() % 5) * 8.0, PLUCK_STRUCK, at);
+          audio_fm_bar(tick / 16, at);
+        }
+        // Fire the mapped one-shots round-robin on every bar's downbeat
+        if (num_one_shots > 0 && tick % 4 == 0) {
+          audio_sample(one_shots[(tick / 4) % num_one_shots], 0.8, at);
+        }
+      }
+      if (ticked) audio_grains_scan(time);
     }
 
-    // Simple "Beat" calculator (approx 480 BPM 16th notes for fast funk)
-    int current_beat_tick = (int)(time * 8.0);
+    audio_additive_sweep(time);
+    audio_fm_automate(time);
 
-    if (current_beat_tick != last_beat_tick) {
-      last_beat_tick = current_beat_tick;
-      // Trigger a random note from the Pentatonic Scale
-      if (rand() % 10 > 2) {  // 80% chance to play
-        double note = get_funky_bass_note(rand() % 15);
-        audio_slap(note);  // Safe producer call
+    if (window) processInput(window);
+    if (g_anim == ANIM_GPU && !visual_gpu_fits(g_cube_target)) {
+      printf("%d cubes exceed the buffer texture limit, animating on the "
+             "CPU\n", g_cube_target);
+      g_anim = ANIM_CPU;
+    }
+    if (g_cube_target != g_cubes.count) {
+      if (visual_set_cubes(g_cube_target)) {
+        if (sweep_step < 0) printf("Cubes: %d\n", g_cubes.count);
+      } else {
+        printf("Failed to allocate %d cubes\n", g_cube_target);
+        g_cube_target = g_cubes.count;
       }
     }
 
-    processInput(window);
+    // Visual controls from OSC (never blocks; empty when --osc is off)
+    OscEvent ev;
+    while (osc_queue_pop(&g_osc_render, &ev)) {
+      osc_latency_note(&g_osc_render_lat, ev.recv_ns, now_ns);
+      if (ev.tag == OSC_SPIN && ev.count >= 1) {
+        spin = ev.v[0];
+      } else if (ev.tag == OSC_BACKGROUND && ev.count >= 3) {
+        for (int c = 0; c < 3; c++) background[c] = ev.v[c];
+      } else if (ev.tag == OSC_FOV && ev.count >= 1 && ev.v[0] >= 1.0f &&
+                 ev.v[0] <= 170.0f) {
+        g_fov = ev.v[0];
+        g_projection_dirty = true;
+      }
+    }
 
     // Clear Screen
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    prof_begin(&g_prof, "clear");
+    glClearColor(background[0], background[1], background[2], 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    prof_end(&g_prof);
+
+    // This frame's upload region, once the GPU has let go of it
+    stream_begin_frame(&g_stream);
+
+    // Camera / View Matrices: the projection only when it's stale, then
+    // the whole per-frame block in one upload
+    bool camera_moved = false;
+    if (g_projection_dirty) {
+      float aspect = g_fb_width > 0 && g_fb_height > 0
+                         ? (float)g_fb_width / (float)g_fb_height
+                         : 1.0f;  // Minimised
+      glm_perspective(glm_rad(g_fov), aspect, 0.1f, 100.0f, projection);
+      memcpy(frame.projection, projection, sizeof(frame.projection));
+      frame.resolution[0] = (float)g_fb_width;
+      frame.resolution[1] = (float)g_fb_height;
+      g_projection_dirty = false;
+      camera_moved = true;
+    }
+    if (g_bench_out) {
+      double t = (double)(frame_index - g_bench_warmup) / g_headless_fps;
+      bench_view(t > 0.0 ? t : 0.0, view);
+      memcpy(frame.view, view, sizeof(frame.view));
+      camera_moved = true;
+    }
+    if (camera_moved) glm_mat4_mul(projection, view, clip);
+    frame.time = (float)time;
+    size_t frame_at;
+    void* frame_dst = stream_map(&g_stream, sizeof(frame),
+                                 (size_t)g_ubo_align, &frame_at);
+    if (frame_dst) {
+      memcpy(frame_dst, &frame, sizeof(frame));
+      stream_unmap(&g_stream);
+      glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BINDING, g_stream.buffer,
+                        (GLintptr)frame_at, sizeof(frame));
+    }
 
-    // Bind Texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glUseProgram(shaderProgram);
-    glBindVertexArray(VAO);
-
-    // Camera / View Matrices
-    mat4 projection = GLM_MAT4_IDENTITY_INIT;
-    glm_perspective(glm_rad(45.0f), 1280.0f / 720.0f, 0.1f, 100.0f, projection);
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, (float*)projection);
-
-    mat4 view = GLM_MAT4_IDENTITY_INIT;
-    glm_translate(view, (vec3){0.0f, 0.0f, -3.0f});
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, (float*)view);
-
-    // Draw all 10 cubes
-    for (int i = 0; i < 10; i++) {
-      mat4 model = GLM_MAT4_IDENTITY_INIT;
-      glm_translate(model, cubePositions[i]);
-      // Rotate based on time and index
-      float angle = 20.0f * i + (float)glfwGetTime() * 25.0f;
-      glm_rotate(model, glm_rad(angle), (vec3){1.0f, 0.3f, 0.5f});
-      glUniformMatrix4fv(modelLoc, 1, GL_FALSE, (float*)model);
-
-      glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    // Spin so far in degrees, wrapped while still in double precision
+    float turn = (float)fmod(time * spin, 360.0);
+    double anim_start = visual_clock();
+
+    // Cull against this frame's camera: workers list each chunk's visible
+    // cubes, then the lists are packed end to end, nearest chunk first
+    int drawn = g_cubes.count;
+    prof_begin(&g_prof, "cull");
+    if (g_cull) {
+      Frustum frustum;
+      cull_planes(&frustum, (float*)clip);
+      workers_run(&g_workers, g_cubes.count, TRANSFORM_CHUNK,
+                  visual_cull_job, &frustum);
+      drawn = visual_pack_chunks(view);
+    }
+    prof_end(&g_prof);
+    double cull = visual_clock() - anim_start;
+
+    prof_begin(&g_prof, "animate");
+    CubeDraw cube_draw = {g_anim != ANIM_GPU, 0, turn, (GLint)turnLoc,
+                          (GLint)culledLoc};
+
+    if (g_anim == ANIM_GPU) {
+      // Nothing per cube: the vertex shader does the rotation, reading
+      // which cube each instance is from the packed visible list
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_BUFFER, g_cube_tex);
+      if (g_cull && drawn > 0) {
+        uint32_t* mapped = (uint32_t*)stream_map(
+            &g_stream, sizeof(uint32_t) * (size_t)drawn, 64, &cube_draw.at);
+        if (mapped) {
+          workers_run(&g_workers, g_cubes.count, TRANSFORM_CHUNK,
+                      visual_index_job, mapped);
+          stream_unmap(&g_stream);
+        } else {
+          drawn = 0;
+        }
+      }
+    } else if (g_anim == ANIM_SIMD) {
+      // Workers spin their share of the cubes and write its matrices
+      // straight into this frame's region of the stream
+      float* mapped =
+          drawn > 0 ? (float*)stream_map(&g_stream,
+                                         sizeof(float) * 16 * (size_t)drawn,
+                                         64, &cube_draw.at)
+                    : NULL;
+      if (mapped) {
+        TransformJob job = {turn, mapped};
+        workers_run(&g_workers, g_cubes.count, TRANSFORM_CHUNK,
+                    visual_transform_job, &job);
+        stream_unmap(&g_stream);
+      } else {
+        drawn = 0;
+      }
+    } else if (g_anim == ANIM_CPU) {
+      // Build every drawn cube's model matrix, then upload them all at once
+      for (int c = 0; c * TRANSFORM_CHUNK < g_cubes.count; c++) {
+        int begin = c * TRANSFORM_CHUNK;
+        int end = g_cubes.count - begin > TRANSFORM_CHUNK
+                      ? begin + TRANSFORM_CHUNK
+                      : g_cubes.count;
+        if (g_cull) end = begin + g_chunk_found[c];
+        // The chunk's stretch of the upload (its packed place when culling)
+        float* out =
+            g_instances + 16 * (size_t)(g_cull ? g_chunk_offset[c] : begin);
+        for (int k = begin; k < end; k++) {
+          int i = g_cull ? (int)g_visible[k] : k;
+          mat4 model = GLM_MAT4_IDENTITY_INIT;
+          glm_translate(model,
+                        (vec3){g_cubes.x[i], g_cubes.y[i], g_cubes.z[i]});
+          // Rotate based on time and index
+          float angle = g_cubes.phase[i] + turn;
+          glm_rotate(model, glm_rad(angle),
+                     (vec3){g_cubes.ax[i], g_cubes.ay[i], g_cubes.az[i]});
+          memcpy(out + 16 * (size_t)(k - begin), model, sizeof(model));
+        }
+      }
+      size_t bytes = sizeof(float) * 16 * (size_t)drawn;
+      void* dst =
+          drawn > 0 ? stream_map(&g_stream, bytes, 64, &cube_draw.at) : NULL;
+      if (dst) {
+        memcpy(dst, g_instances, bytes);
+        stream_unmap(&g_stream);
+      } else {
+        drawn = 0;
+      }
+    }
+    prof_end(&g_prof);
+    double anim = visual_clock() - anim_start;
+    // Queue the frame's draws and issue them sorted: every drawn cube in a
+    // single instanced call, then the profile graph over them
+    prof_begin(&g_prof, "draw");
+    if (drawn > 0) {
+      RenderPacket cubes = {programs[g_anim], texture, VAO, visual_draw_cubes,
+                            &cube_draw, drawn};
+      rq_add(&g_queue, RQ_OPAQUE, 0.0f, &cubes);
+    }
+    if (g_profile_graph) queue_profile();
+    rq_submit(&g_queue);
+    prof_end(&g_prof);
+    FrameCost cost = {anim, cull, g_stream.stall, drawn,
+                      (double)g_stream.bytes};
+
+    // Output meters over the scene, plus numbers in the title bar a few
+    // times a second (the reading is whatever the audio thread last sent)
+    prof_begin(&g_prof, "overlay");
+    MeterReading levels;
+    meter_read(&g_meter, &levels);
+    draw_meters(&levels);
+    prof_end(&g_prof);
+    // Headless, the same line goes to stdout once a (simulated) second
+    if (time - last_title >= (window ? 0.25 : 1.0) && title_stats.n > 0) {
+      last_title = time;
+      char title[320];
+      snprintf(title, sizeof(title),
+               "C Demo Engine | peak %.1f dBFS | RMS %.1f dBFS | %.1f LUFS "
+               "| GR %.1f dB | %d cubes, %.0f drawn (%s) | %.2f ms (anim "
+               "%.2f, cull %.2f, stall %.2f) | %.2f MB up | %d draws, %d "
+               "binds (%d as queued) | %s bound",
+               levels.peak_db, levels.rms_db, levels.short_lufs,
+               levels.reduction_db, g_cubes.count,
+               title_stats.cost.drawn / title_stats.n, k_anim_names[g_anim],
+               title_stats.sum / title_stats.n * 1000.0,
+               title_stats.cost.anim / title_stats.n * 1000.0,
+               title_stats.cost.cull / title_stats.n * 1000.0,
+               title_stats.cost.stall / title_stats.n * 1000.0,
+               title_stats.cost.uploaded / title_stats.n / 1e6,
+               g_queue.issued, g_queue.binds, g_queue.binds_unsorted,
+               visual_bound());
+      if (window) {
+        glfwSetWindowTitle(window, title);
+      } else {
+        printf("%s\n", title);
+      }
+      title_stats = (FrameStats){0};
     }
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+    double cpu = visual_clock() - frame_start;
+    prof_begin(&g_prof, "save");
+    if (g_frames_out && !visual_save_frame(g_frames_out, frame_index)) {
+      printf("Failed to write frame %lld to %s\n", frame_index, g_frames_out);
+      g_frames_out = NULL;
+    }
+    prof_end(&g_prof);
+    // Hand the frame over: fence its uploads and present it
+    prof_begin(&g_prof, "swap");
+    stream_end_frame(&g_stream);
+    if (window) {
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+    } else {
+      glFlush();  // Nothing to present; the stream's fences pace us
+    }
+    prof_end(&g_prof);
+    prof_end(&g_prof);  // frame
+
+    // Frame time, swap to swap
+    double frame_end = visual_clock();
+    double dt = frame_end - last_frame;
+    last_frame = frame_end;
+    frame_stats_add(&title_stats, dt, &cost);
+    if (g_bench_out && frame_index >= g_bench_warmup) {
+      perf_add(&g_perf, PERF_FRAME, dt * 1000.0);
+      perf_add(&g_perf, PERF_CPU, cpu * 1000.0);
+    }
+    if (++frame_index == g_frame_limit ||
+        (g_bench_out && frame_index >= g_bench_warmup + bench_frames)) {
+      visual_close(window);
+    }
+    if (sweep_step >= 0 && ++sweep_frame > SWEEP_WARMUP) {
+      frame_stats_add(&sweep_stats, dt, &cost);
+      if (sweep_stats.n == SWEEP_FRAMES) {
+        const FrameCost* c = &sweep_stats.cost;
+        double n = sweep_stats.n;
+        printf("  %8d cubes: %8.2f ms avg, %8.2f ms worst, %7.3f ms animating "
+               "(%.3f culling), %.0f drawn, %.2f MB up, %.3f ms stalled\n",
+               g_cubes.count, sweep_stats.sum / n * 1000.0,
+               sweep_stats.max * 1000.0, c->anim / n * 1000.0,
+               c->cull / n * 1000.0, c->drawn / n, c->uploaded / n / 1e6,
+               c->stall / n * 1000.0);
+        sweep_stats = (FrameStats){0};
+        sweep_frame = 0;
+        int steps = (int)(sizeof(k_sweep_counts) / sizeof(k_sweep_counts[0]));
+        if (++sweep_step < steps) {
+          g_cube_target = k_sweep_counts[sweep_step];
+        } else {
+          visual_close(window);
+        }
+      }
+    }
   }
+  // Read back the frames still in flight
+  for (long long done; (done = prof_drain(&g_prof)) >= 0;) {
+    bench_frame_done(done);
+  }
+  if (g_profile) prof_print(&g_prof);
+  int status = g_bench_out ? bench_finish() : 0;
+  prof_free(&g_prof);
+  rq_free(&g_queue);
+
   // cleanup
   audio_shutdown();
-  glfwTerminate();
-  return 0;
+  if (g_osc_on) {
+    osc_latency_print(&g_osc_audio_lat, "receive -> audio thread");
+    osc_latency_print(&g_osc_render_lat, "receive -> render loop");
+  }
+  if (g_recording) {
+    recorder_close(&g_rec);  // The audio thread is gone, safe to drain
+  }
+  workers_stop(&g_workers);
+  cubes_free(&g_cubes);
+  transforms_free(&g_xforms);
+  free(g_instances);
+  free(g_visible);
+  free(g_chunk_found);
+  free(g_chunk_offset);
+  free(g_chunk_bounds);
+  stream_free(&g_stream);
+  if (window) {
+    glfwTerminate();
+  } else {
+#ifdef HAVE_EGL
+    headless_close(&offscreen);
+#endif
+  }
+  return status;
 }
 
 void processInput(GLFWwindow* window) {
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
     glfwSetWindowShouldClose(window, true);
   }
+  // Up/Down scale the cube count by ten, once per key press
+  static bool up_held = false, down_held = false;
+  bool up = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+  bool down = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+  if (up && !up_held) {
+    g_cube_target = g_cubes.count > CUBES_MAX / 10 ? CUBES_MAX
+                                                   : g_cubes.count * 10;
+  }
+  if (down && !down_held && g_cubes.count >= 10) {
+    g_cube_target = g_cubes.count / 10;
+  }
+  up_held = up;
+  down_held = down;
+
+  // G cycles through the animation modes
+  static bool g_held = false;
+  bool g = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+  if (g && !g_held) g_anim = (AnimMode)((g_anim + 1) % ANIM_MODES);
+  g_held = g;
+
+  // C turns frustum culling on and off
+  static bool c_held = false;
+  bool c = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+  if (c && !c_held) g_cull = !g_cull;
+  c_held = c;
+
+  // P shows and hides the profiler graph
+  static bool p_held = false;
+  bool p = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+  if (p && !p_held) g_profile_graph = !g_profile_graph;
+  p_held = p;
+}
+
+// Fill one screen rectangle with a flat colour (no shader needed)
+static void fill_rect(int x, int y, int w, int h, float r, float g, float b) {
+  if (w <= 0 || h <= 0) return;
+  glScissor(x, y, w, h);
+  glClearColor(r, g, b, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+}
+
+// Map a dB value onto 0..1 of the meter's range
+static float meter_fraction(float db) {
+  float f = (db - METER_FLOOR_DB) / -METER_FLOOR_DB;
+  return f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+}
+
+// Peak, RMS and short-term loudness bars in the bottom-left corner, with the
+// limiter's gain reduction hanging from the top (0..12 dB).
+void draw_meters(const MeterReading* m) {
+  int x = 10, y = 10, w = 12, gap = 4;
+  int h = g_fb_height / 3;
+
+  glEnable(GL_SCISSOR_TEST);
+  fill_rect(x - 4, y - 4, 4 * (w + gap) + 4, h + 8, 0.05f, 0.05f, 0.05f);
+
+  bool hot = m->peak_db > -1.0f;
+  fill_rect(x, y, w, (int)(h * meter_fraction(m->peak_db)),
+            hot ? 1.0f : 0.9f, hot ? 0.2f : 0.9f, hot ? 0.2f : 0.9f);
+  x += w + gap;
+  fill_rect(x, y, w, (int)(h * meter_fraction(m->rms_db)), 0.2f, 0.8f,
+            0.3f);
+  x += w + gap;
+  fill_rect(x, y, w, (int)(h * meter_fraction(m->short_lufs)), 0.3f, 0.5f,
+            1.0f);
+  x += w + gap;
+  float gr = m->reduction_db / 12.0f;
+  int gr_h = (int)(h * (gr > 1.0f ? 1.0f : gr));
+  fill_rect(x, y + h - gr_h, w, gr_h, 1.0f, 0.4f, 0.1f);
+
+  glDisable(GL_SCISSOR_TEST);
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
   glViewport(0, 0, width, height);
+  g_fb_width = width;
+  g_fb_height = height;
+  g_projection_dirty = true;
+}
+
+// Append a flat-coloured rectangle (pixels from the bottom-left) as two
+// triangles of x, y, r, g, b
+static float* graph_quad(float* v, float x, float y, float w, float h,
+                         const float c[3]) {
+  const float corner[6][2] = {{x, y},     {x + w, y},     {x + w, y + h},
+                              {x, y},     {x + w, y + h}, {x, y + h}};
+  for (int k = 0; k < 6; k++) {
+    *v++ = corner[k][0];
+    *v++ = corner[k][1];
+    *v++ = c[0];
+    *v++ = c[1];
+    *v++ = c[2];
+  }
+  return v;
+}
+
+// Zone colours, in the order the loop first enters them: frame (not
+// drawn), then blue clear, yellow cull, orange animate, red draw, purple
+// overlay, cyan save, green swap
+static const float k_zone_colors[8][3] = {
+    {0.6f, 0.6f, 0.6f}, {0.4f, 0.6f, 1.0f}, {1.0f, 0.85f, 0.2f},
+    {1.0f, 0.5f, 0.1f}, {0.9f, 0.2f, 0.3f}, {0.7f, 0.4f, 1.0f},
+    {0.2f, 0.9f, 0.9f}, {0.3f, 0.8f, 0.4f}};
+
+// Stack `value` ms of colour `c` on a bar at (x, *y), clipped to the top
+static float* graph_stack(float* v, float x, float* y, float w, float value,
+                          const float c[3]) {
+  float top = GRAPH_BOTTOM + GRAPH_HEIGHT;
+  float h = value * (GRAPH_HEIGHT / GRAPH_MS);
+  if (*y + h > top) h = top - *y;
+  if (h <= 0.0f) return v;
+  v = graph_quad(v, x, *y, w, h, c);
+  *y += h;
+  return v;
+}
+
+// The profiler's last PROF_HISTORY frames in the bottom-right corner,
+// newest on the right: each frame's passes stacked by CPU time with a
+// white tick at its GPU time, a grey line at 16.7 ms, then two bars of
+// rolling averages, CPU per pass and GPU per pass. Queued as an overlay.
+void queue_profile(void) {
+  size_t at;
+  float* start = (float*)stream_map(&g_stream, GRAPH_BYTES, 64, &at);
+  if (!start) return;
+  static const float dark[3] = {0.05f, 0.05f, 0.05f};
+  static const float grey[3] = {0.5f, 0.5f, 0.5f};
+  static const float white[3] = {1.0f, 1.0f, 1.0f};
+  float bar = 12.0f, gap = 4.0f;
+  float w = (float)(PROF_HISTORY * GRAPH_PX_PER_FRAME);
+  float x0 = (float)g_fb_width - 10.0f - w - 2.0f * (bar + gap);
+  float y0 = GRAPH_BOTTOM;
+  float px = GRAPH_HEIGHT / GRAPH_MS;
+
+  float* v = graph_quad(start, x0 - 4.0f, y0 - 4.0f,
+                        w + 2.0f * (bar + gap) + 8.0f, GRAPH_HEIGHT + 8.0f,
+                        dark);
+  int frames = g_prof.collected < PROF_HISTORY ? (int)g_prof.collected
+                                               : PROF_HISTORY;
+  for (int k = 0; k < frames; k++) {
+    float x = x0 + w - (float)((k + 1) * GRAPH_PX_PER_FRAME);
+    float y = y0;
+    for (int z = 0; z < g_prof.zone_count; z++) {
+      if (g_prof.zones[z].depth != 1) continue;
+      v = graph_stack(v, x, &y, GRAPH_PX_PER_FRAME,
+                      prof_ms(&g_prof, z, k, false), k_zone_colors[z % 8]);
+    }
+    float gpu = (float)visual_gpu_ms(k) * px;
+    if (gpu < GRAPH_HEIGHT) {
+      v = graph_quad(v, x, y0 + gpu, GRAPH_PX_PER_FRAME, 2.0f, white);
+    }
+  }
+  v = graph_quad(v, x0, y0 + 16.7f * px, w, 1.0f, grey);
+
+  float cpu_y = y0, gpu_y = y0;
+  for (int z = 0; z < g_prof.zone_count; z++) {
+    if (g_prof.zones[z].depth != 1) continue;
+    v = graph_stack(v, x0 + w + gap, &cpu_y, bar,
+                    (float)prof_average(&g_prof, z, false),
+                    k_zone_colors[z % 8]);
+    for (int k = 0; k < GPU_PASSES; k++) {
+      if (strcmp(g_prof.zones[z].name, k_gpu_passes[k]) != 0) continue;
+      v = graph_stack(v, x0 + w + 2.0f * gap + bar, &gpu_y, bar,
+                      (float)prof_average(&g_prof, z, true),
+                      k_zone_colors[z % 8]);
+    }
+  }
+  stream_unmap(&g_stream);
+  g_graph_at = at;
+  RenderPacket graph = {g_graph_program, 0, g_graph_vao, draw_profile_graph,
+                        NULL, (int)((v - start) / 5)};
+  rq_add(&g_queue, RQ_OVERLAY, 0.0f, &graph);
+}
+
+void draw_profile_graph(void* ctx, int vertices) {
+  (void)ctx;
+  glDisable(GL_DEPTH_TEST);
+  glBindBuffer(GL_ARRAY_BUFFER, g_stream.buffer);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                        (void*)g_graph_at);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                        (void*)(g_graph_at + 2 * sizeof(float)));
+  glDrawArrays(GL_TRIANGLES, 0, vertices);
+  glEnable(GL_DEPTH_TEST);
 }
@@ -0,0 +1,171 @@
+#include "dynamics.h"
+
+#include <math.h>
+#include <string.h>
+
+#define DELAY (DYN_LOOKAHEAD - 1)
+
+static float step_coef(double ms, double sample_rate, int step) {
+  // One-pole coefficient for a time constant of `ms`, updated every `step`
+  return (float)(1.0 - exp(-step / (ms * 0.001 * sample_rate)));
+}
+
+void dynamics_init(Dynamics* d, double sample_rate) {
+  memset(d, 0, sizeof(*d));
+  d->sample_rate = sample_rate;
+
+  d->threshold_db = -12.0f;
+  d->ratio = 3.0f;
+  d->knee_db = 6.0f;
+  d->makeup_db = 3.0f;
+  d->attack_coef = step_coef(10.0, sample_rate, DYN_CONTROL_STEP);
+  d->release_coef = step_coef(150.0, sample_rate, DYN_CONTROL_STEP);
+  d->ms_coef = step_coef(30.0, sample_rate, 1);
+  d->comp_gain = powf(10.0f, d->makeup_db / 20.0f);
+
+  d->ceiling = powf(10.0f, -1.0f / 20.0f);  // -1 dBFS
+  d->lim_release = step_coef(50.0, sample_rate, 1);
+  d->held = 1.0f;
+  for (int i = 0; i < DYN_LOOKAHEAD; i++) d->box[i] = 1.0f;
+  d->box_sum = DYN_LOOKAHEAD;
+  d->min_gain = 1.0f;
+  d->quiet = DELAY;  // The delay line starts out empty
+}
+
+int dynamics_latency(const Dynamics* d) {
+  (void)d;
+  return DELAY;
+}
+
+float dynamics_take_min_gain(Dynamics* d) {
+  float g = d->min_gain;
+  d->min_gain = 1.0f;
+  return g;
+}
+
+// Static curve: gain reduction in dB for a detector level, soft knee.
+static float comp_curve(const Dynamics* d, float level_db) {
+  float over = level_db - d->threshold_db;
+  float slope = 1.0f - 1.0f / d->ratio;
+  float half = 0.5f * d->knee_db;
+  if (over <= -half) return 0.0f;
+  if (over >= half) return over * slope;
+  float k = over + half;
+  return slope * k * k / (2.0f * d->knee_db);
+}
+
+float dynamics_window_min(Dynamics* d, float r) {
+  const int mask = DYN_LOOKAHEAD - 1;
+  long long now = d->clock++;
+
+  // Expire the front once it falls out of the window, before pushing, so
+  // at most DYN_LOOKAHEAD entries are ever live
+  if (d->dq_count > 0 && d->dq_time[d->dq_head] <= now - DYN_LOOKAHEAD) {
+    d->dq_head = (d->dq_head + 1) & mask;
+    d->dq_count--;
+  }
+
+  // Anything at the back that needs less reduction than r can never be the
+  // minimum again while r is in the window
+  while (d->dq_count > 0) {
+    int back = (d->dq_head + d->dq_count - 1) & mask;
+    if (d->dq_gain[back] < r) break;
+    d->dq_count--;
+  }
+  int slot = (d->dq_head + d->dq_count) & mask;
+  d->dq_time[slot] = now;
+  d->dq_gain[slot] = r;
+  d->dq_count++;
+  return d->dq_gain[d->dq_head];
+}
+
+bool dynamics_at_rest(const Dynamics* d) {
+  return d->quiet >= DELAY && d->held == 1.0f && d->box_low == 0 &&
+         d->reduction_db < 1e-3f;
+}
+
+bool dynamics_process(Dynamics* d, float* buf, int n, bool silent) {
+  if (silent && dynamics_at_rest(d)) {
+    d->mean_sq *= pow(1.0 - d->ms_coef, n);
+    d->reduction_db = 0.0f;
+    d->comp_gain = powf(10.0f, d->makeup_db / 20.0f);
+    d->clock += n;
+    d->dq_count = 0;  // Every entry was 1.0, the next sample starts afresh
+    d->quiet += n;
+    return false;
+  }
+  // The output lags the input by DELAY samples
+  bool out_silent = silent && d->quiet >= DELAY;
+  d->quiet = silent ? d->quiet + n : 0;
+
+  float* in = d->delay + DELAY;  // New samples go after the history
+
+  // 1. Compressor: RMS detector per sample, gain curve per control step,
+  // linearly interpolated so the applied gain is smooth.
+  for (int i0 = 0; i0 < n; i0 += DYN_CONTROL_STEP) {
+    int m = n - i0 < DYN_CONTROL_STEP ? n - i0 : DYN_CONTROL_STEP;
+    double ms = d->mean_sq;
+    for (int i = i0; i < i0 + m; i++) {
+      ms += d->ms_coef * ((double)buf[i] * buf[i] - ms);
+    }
+    d->mean_sq = ms;
+
+    float level_db = 10.0f * log10f((float)ms + 1e-12f);
+    float target = comp_curve(d, level_db);
+    float coef = target > d->reduction_db ? d->attack_coef : d->release_coef;
+    d->reduction_db += coef * (target - d->reduction_db);
+
+    float next = powf(10.0f, (d->makeup_db - d->reduction_db) / 20.0f);
+    float g = d->comp_gain;
+    float dg = (next - g) / (float)m;
+    for (int i = i0; i < i0 + m; i++) {
+      g += dg;
+      in[i] = buf[i] * g;
+    }
+    d->comp_gain = next;
+  }
+
+  // 2. Limiter gain curve: required gain -> window minimum (with release)
+  // -> box average over the window.
+  const int mask = DYN_LOOKAHEAD - 1;
+  float min_gain = d->min_gain;
+  for (int i = 0; i < n; i++) {
+    float peak = fabsf(in[i]);
+    float r = peak > d->ceiling ? d->ceiling / peak : 1.0f;
+    float h = dynamics_window_min(d, r);
+
+    // Recover slowly, but never above what the window demands. Near 1 the
+    // step drops below half an ulp and would stall, so snap the rest.
+    float rel = d->held + (1.0f - d->held) * d->lim_release;
+    if (1.0f - rel < DYN_REST_GAP) rel = 1.0f;
+    d->held = h < rel ? h : rel;
+
+    float old = d->box[d->box_pos];
+    d->box_low += (d->held < 1.0f) - (old < 1.0f);
+    d->box_sum += d->held - old;
+    // Once the window is all 1 again, drop the running sum's drift
+    if (d->box_low == 0) d->box_sum = DYN_LOOKAHEAD;
+    d->box[d->box_pos] = d->held;
+    d->box_pos = (d->box_pos + 1) & mask;
+    float g = (float)(d->box_sum / DYN_LOOKAHEAD);
+    d->gain[i] = g;
+    if (g < min_gain) min_gain = g;
+  }
+  d->min_gain = min_gain;
+
+  // 3. Apply: delayed signal times gain curve, a plain vector multiply.
+  // The guard clamp catches the rounding of the running sum.
+  const float* restrict src = d->delay;
+  const float* restrict gain = d->gain;
+  float ceil = d->ceiling;
+  for (int i = 0; i < n; i++) {
+    float y = src[i] * gain[i];
+    y = y > ceil ? ceil : y;
+    y = y < -ceil ? -ceil : y;
+    buf[i] = y;
+  }
+
+  // Keep the last DELAY samples as history for the next block
+  memmove(d->delay, d->delay + n, sizeof(float) * DELAY);
+  return !out_silent;
+}
@@ -0,0 +1,90 @@
+#ifndef DYNAMICS_H
+#define DYNAMICS_H
+
+// --- MASTER DYNAMICS ---
+// An RMS compressor followed by a look-ahead brickwall limiter on the float
+// master bus, so overlapping voices get squeezed instead of hard-clipping
+// when they're converted to 16-bit.
+//
+// The limiter delays the signal by DYN_LOOKAHEAD - 1 samples. Its detector
+// keeps a sliding-window peak with a monotonic deque (O(1) per sample), and
+// the gain curve is box-smoothed over the same window so it has fully
+// arrived by the time the peak leaves the delay line. Both stages build a
+// per-block gain curve first and then apply it in one vectorisable pass.
+
+#include <stdbool.h>
+
+#define DYN_LOOKAHEAD 64     // Limiter window (power of two), ~1.5 ms
+#define DYN_MAX_BLOCK 1024   // Largest block dynamics_process accepts
+#define DYN_CONTROL_STEP 16  // Compressor gain is recomputed this often
+#define DYN_REST_GAP 1e-3f   // Limiter gain this near 1 snaps to 1 (0.01 dB)
+
+typedef struct {
+  double sample_rate;
+
+  // Compressor settings
+  float threshold_db;
+  float ratio;
+  float knee_db;
+  float makeup_db;
+  float attack_coef;   // Per control step
+  float release_coef;  // Per control step
+
+  // Compressor state
+  double mean_sq;  // RMS detector (one-pole on x^2)
+  float ms_coef;
+  float reduction_db;  // Smoothed gain reduction
+  float comp_gain;     // Linear gain at the end of the last control step
+
+  // Limiter settings
+  float ceiling;  // Linear peak ceiling
+  float lim_release;
+
+  // Limiter state: monotonic deque of (time, required gain), increasing
+  // gains from front to back, so the front is the window minimum.
+  long long dq_time[DYN_LOOKAHEAD];
+  float dq_gain[DYN_LOOKAHEAD];
+  int dq_head;
+  int dq_count;
+  long long clock;
+  float held;  // Window minimum after release smoothing
+  float box[DYN_LOOKAHEAD];
+  int box_pos;
+  int box_low;  // Entries of box below 1
+  double box_sum;
+
+  // Delay line: DYN_LOOKAHEAD - 1 samples of history then the new block
+  float delay[DYN_LOOKAHEAD - 1 + DYN_MAX_BLOCK];
+  float gain[DYN_MAX_BLOCK];
+
+  float min_gain;  // Deepest limiter gain since the last take (metering)
+  long long quiet;  // Consecutive silent input samples
+} Dynamics;
+
+void dynamics_init(Dynamics* d, double sample_rate);
+
+// Compress and limit n (<= DYN_MAX_BLOCK) samples in place. `silent` tells
+// it buf is all zeros; once the delay line has drained and the gains have
+// recovered, such blocks skip the DSP entirely. Returns false when the
+// output block is silent.
+bool dynamics_process(Dynamics* d, float* buf, int n, bool silent);
+
+// Would a silent block skip the DSP? True once the delay line has drained
+// and both gain stages have fully recovered.
+bool dynamics_at_rest(const Dynamics* d);
+
+// Deepest limiter gain (linear) since the previous call, then resets it.
+// Audio thread only.
+float dynamics_take_min_gain(Dynamics* d);
+
+// Slide the limiter's peak window on by one sample that needs gain `r`
+// (ceiling / peak, at most 1) and return the smallest gain still in the
+// last DYN_LOOKAHEAD samples. dynamics_process calls this per sample; it's
+// exposed for bench_dynamics to check against a brute-force minimum.
+float dynamics_window_min(Dynamics* d, float r);
+
+// Samples of delay the limiter adds; A/V sync should add this to the
+// device latency.
+int dynamics_latency(const Dynamics* d);
+
+#endif
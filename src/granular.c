@@ -0,0 +1,160 @@
+#include "granular.h"
+
+#include <math.h>
+#include <string.h>
+
+static uint32_t gr_rand(GranularEngine* ge) {
+  uint32_t x = ge->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return ge->rng = x;
+}
+
+// Uniform in [-1, 1)
+static double gr_bipolar(GranularEngine* ge) {
+  return (double)gr_rand(ge) / 2147483648.0 - 1.0;
+}
+
+void granular_init(GranularEngine* ge, double sample_rate, uint32_t seed) {
+  memset(ge, 0, sizeof(*ge));
+  ge->sample_rate = sample_rate;
+  ge->rng = seed ? seed : 1u;
+
+  ge->params.density = 50.0;
+  ge->params.duration_sec = 0.08;
+  ge->params.position = 0.5;
+  ge->params.position_jitter = 0.5;
+  ge->params.rate = 1.0;
+  ge->params.rate_jitter = 0.0;
+  ge->params.amp = 0.1f;
+  ge->params.window = GRAIN_WIN_HANN;
+
+  // Window tables are filled once here; the audio thread only indexes them
+  for (int i = 0; i < GRAIN_TABLE_LEN; i++) {
+    double x = (double)i / GRAIN_TABLE_LEN;  // 0..1 across the grain
+    ge->tables[GRAIN_WIN_HANN][i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * x));
+    double g = (x - 0.5) / 0.15;
+    ge->tables[GRAIN_WIN_GAUSS][i] = (float)exp(-0.5 * g * g);
+    double t = x < 0.1 ? x / 0.1 : (x > 0.9 ? (1.0 - x) / 0.1 : 1.0);
+    ge->tables[GRAIN_WIN_TRAPEZOID][i] = (float)t;
+  }
+}
+
+void granular_set_source(GranularEngine* ge, const float* src, size_t frames) {
+  ge->src = src;
+  ge->src_frames = frames;
+  ge->active = 0;  // Old grains point into the old buffer
+}
+
+void granular_set_params(GranularEngine* ge, const GranularParams* p) {
+  ge->params = *p;
+}
+
+// Decide this block's new grains up front: how many, and where in the block
+// each one starts, so the per-sample loop below has no scheduling in it.
+static void schedule_block(GranularEngine* ge, int n) {
+  const GranularParams* p = &ge->params;
+  if (!ge->src || ge->src_frames < 4 || p->density <= 0.0) return;
+
+  ge->spawn_acc += p->density * n / ge->sample_rate;
+  int count = (int)ge->spawn_acc;
+  ge->spawn_acc -= count;
+
+  int dur = (int)(p->duration_sec * ge->sample_rate);
+  if (dur < 2) dur = 2;
+
+  for (int k = 0; k < count; k++) {
+    if (ge->active == GRAIN_MAX) {
+      ge->dropped += (unsigned long long)(count - k);
+      break;
+    }
+
+    double rate = p->rate * (1.0 + p->rate_jitter * gr_bipolar(ge));
+    if (rate <= 0.0) rate = 1e-3;
+    // Keep the whole grain inside the source so reads need no bounds checks
+    double span = rate * dur + 2.0;
+    double room = (double)ge->src_frames - span;
+    if (room <= 0.0) {
+      ge->dropped++;
+      continue;
+    }
+    double at = p->position + p->position_jitter * gr_bipolar(ge);
+    if (at < 0.0) at = 0.0;
+    if (at > 1.0) at = 1.0;
+
+    int g = ge->active++;
+    ge->pos[g] = at * room;
+    ge->step[g] = rate;
+    ge->win_phase[g] = 0;
+    ge->win_inc[g] = (uint32_t)(4294967296.0 / dur);
+    ge->gain[g] = p->amp;
+    ge->left[g] = dur;
+    ge->onset[g] = (int)(((uint64_t)gr_rand(ge) * (uint64_t)n) >> 32);
+    ge->window[g] = (uint8_t)p->window;
+    ge->spawned++;
+  }
+}
+
+bool granular_render(GranularEngine* ge, float* out, int n) {
+  memset(out, 0, sizeof(float) * (size_t)n);
+  schedule_block(ge, n);
+  if (ge->active == 0) return false;
+
+  const float* src = ge->src;
+  for (int g = 0; g < ge->active;) {
+    const float* win = ge->tables[ge->window[g]];
+    int start = ge->onset[g];
+    int count = n - start;
+    if (count > ge->left[g]) count = ge->left[g];
+
+    // Grain-major: one grain streams through the (L1-resident) output block
+    double pos = ge->pos[g];
+    double step = ge->step[g];
+    uint32_t ph = ge->win_phase[g];
+    uint32_t inc = ge->win_inc[g];
+    float gain = ge->gain[g];
+    for (int i = start; i < start + count; i++) {
+      size_t idx = (size_t)pos;
+      float frac = (float)(pos - (double)idx);
+      float s = src[idx] + (src[idx + 1] - src[idx]) * frac;
+      out[i] += s * win[ph >> (32 - GRAIN_TABLE_BITS)] * gain;
+      pos += step;
+      ph += inc;
+    }
+    ge->pos[g] = pos;
+    ge->win_phase[g] = ph;
+    ge->left[g] -= count;
+    ge->onset[g] = 0;
+
+    if (ge->left[g] <= 0) {
+      // Finished: move the last active grain into this slot
+      int last = --ge->active;
+      ge->pos[g] = ge->pos[last];
+      ge->step[g] = ge->step[last];
+      ge->win_phase[g] = ge->win_phase[last];
+      ge->win_inc[g] = ge->win_inc[last];
+      ge->gain[g] = ge->gain[last];
+      ge->left[g] = ge->left[last];
+      ge->onset[g] = ge->onset[last];
+      ge->window[g] = ge->window[last];
+    } else {
+      g++;
+    }
+  }
+  return true;
+}
+
+void granular_mix(GranularEngine* ge, int16_t* out, int n) {
+  float tmp[1024];
+  for (int off = 0; off < n; off += 1024) {
+    int m = n - off < 1024 ? n - off : 1024;
+    if (!granular_render(ge, tmp, m)) continue;
+    for (int i = 0; i < m; i++) {
+      int mixed = out[off + i] + (int)(tmp[i] * 32767.0f);
+      if (mixed > 32767) mixed = 32767;
+      if (mixed < -32768) mixed = -32768;
+      out[off + i] = (int16_t)mixed;
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef GRANULAR_H
+#define GRANULAR_H
+
+// --- GRANULAR TEXTURE ENGINE ---
+// Scatters thousands of short windowed "grains" read out of a source buffer
+// (a loaded sample or something rendered offline) to build evolving pads
+// under the visuals. Grains live in a fixed pool, so spawning one never
+// allocates; window shapes come from precomputed tables; and spawning is
+// decided once per block, with each new grain given a sample-accurate onset.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define GRAIN_MAX 8192         // Pool size (concurrent grains)
+#define GRAIN_TABLE_BITS 12    // 4096-entry window tables
+#define GRAIN_TABLE_LEN (1 << GRAIN_TABLE_BITS)
+
+typedef enum {
+  GRAIN_WIN_HANN,
+  GRAIN_WIN_GAUSS,
+  GRAIN_WIN_TRAPEZOID,
+  GRAIN_WIN_COUNT,
+} GrainWindow;
+
+// Scheduling parameters. Positions are 0..1 across the source buffer,
+// rate is playback speed (1.0 = original pitch), jitters are +/- ranges.
+typedef struct {
+  double density;  // Grains started per second
+  double duration_sec;
+  double position;
+  double position_jitter;
+  double rate;
+  double rate_jitter;
+  float amp;
+  GrainWindow window;
+} GranularParams;
+
+typedef struct {
+  const float* src;
+  size_t src_frames;
+  GranularParams params;
+
+  // Grain pool, structure-of-arrays. Active grains are packed in [0, active)
+  double pos[GRAIN_MAX];   // Read position in source frames
+  double step[GRAIN_MAX];  // Source frames per output sample
+  uint32_t win_phase[GRAIN_MAX];
+  uint32_t win_inc[GRAIN_MAX];
+  float gain[GRAIN_MAX];
+  int left[GRAIN_MAX];   // Output samples until the grain ends
+  int onset[GRAIN_MAX];  // First sample of the current block it plays in
+  uint8_t window[GRAIN_MAX];
+  int active;
+
+  double spawn_acc;  // Fractional grains carried between blocks
+  uint32_t rng;
+  double sample_rate;
+  unsigned long long spawned;
+  unsigned long long dropped;  // Spawns refused because the pool was full
+
+  float tables[GRAIN_WIN_COUNT][GRAIN_TABLE_LEN];
+} GranularEngine;
+
+void granular_init(GranularEngine* ge, double sample_rate, uint32_t seed);
+
+// The buffer must outlive the engine. Audio thread only, or before the
+// device starts.
+void granular_set_source(GranularEngine* ge, const float* src, size_t frames);
+void granular_set_params(GranularEngine* ge, const GranularParams* p);
+
+// Render n samples into out (overwrites). Returns false when no grain was
+// playing, i.e. out is silent.
+bool granular_render(GranularEngine* ge, float* out, int n);
+
+// Render and mix into the 16-bit bus with saturation. Audio thread only.
+void granular_mix(GranularEngine* ge, int16_t* out, int n);
+
+#endif
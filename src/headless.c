@@ -0,0 +1,144 @@
+#include "headless.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+#include <stdio.h>
+#include <string.h>
+
+void* headless_proc_address(const char* name) {
+  return (void*)eglGetProcAddress(name);
+}
+
+// Mesa's surfaceless platform needs no display server at all; otherwise
+// fall back to whatever the default display is
+static EGLDisplay open_display(void) {
+  const char* exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+          "eglGetPlatformDisplayEXT");
+  if (exts && strstr(exts, "EGL_MESA_platform_surfaceless") &&
+      get_platform_display) {
+    EGLDisplay d = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                        EGL_DEFAULT_DISPLAY, NULL);
+    if (d != EGL_NO_DISPLAY && eglInitialize(d, NULL, NULL)) return d;
+  }
+  EGLDisplay d = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (d != EGL_NO_DISPLAY && eglInitialize(d, NULL, NULL)) return d;
+  return EGL_NO_DISPLAY;
+}
+
+int headless_open(Headless* h, int width, int height) {
+  memset(h, 0, sizeof(*h));
+  h->width = width;
+  h->height = height;
+
+  EGLDisplay display = open_display();
+  if (display == EGL_NO_DISPLAY) {
+    printf("Headless: no EGL display\n");
+    return 0;
+  }
+  h->display = display;
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    printf("Headless: EGL has no desktop OpenGL\n");
+    headless_close(h);
+    return 0;
+  }
+
+  const EGLint config_attribs[] = {EGL_SURFACE_TYPE,
+                                   EGL_PBUFFER_BIT,
+                                   EGL_RENDERABLE_TYPE,
+                                   EGL_OPENGL_BIT,
+                                   EGL_RED_SIZE,
+                                   8,
+                                   EGL_GREEN_SIZE,
+                                   8,
+                                   EGL_BLUE_SIZE,
+                                   8,
+                                   EGL_NONE};
+  EGLConfig config;
+  EGLint configs = 0;
+  if (!eglChooseConfig(display, config_attribs, &config, 1, &configs) ||
+      configs < 1) {
+    printf("Headless: no suitable EGL config\n");
+    headless_close(h);
+    return 0;
+  }
+
+  // Same version and profile as the windowed context
+  const EGLint context_attribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                    3,
+                                    EGL_CONTEXT_MINOR_VERSION,
+                                    3,
+                                    EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                    EGL_NONE};
+  EGLContext context =
+      eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+  if (context == EGL_NO_CONTEXT) {
+    printf("Headless: couldn't create a GL 3.3 core context\n");
+    headless_close(h);
+    return 0;
+  }
+  h->context = context;
+
+  // Everything is drawn into our own framebuffer, so no surface is needed
+  // where EGL_KHR_surfaceless_context allows it; a 1x1 pbuffer otherwise
+  EGLSurface surface = EGL_NO_SURFACE;
+  if (!eglMakeCurrent(display, surface, surface, context)) {
+    const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+    h->surface = surface;
+    if (surface == EGL_NO_SURFACE ||
+        !eglMakeCurrent(display, surface, surface, context)) {
+      printf("Headless: couldn't make the context current\n");
+      headless_close(h);
+      return 0;
+    }
+  }
+
+  if (!gladLoadGLLoader((GLADloadproc)headless_proc_address)) {
+    printf("Failed to initialize GLAD\n");
+    headless_close(h);
+    return 0;
+  }
+
+  glGenFramebuffers(1, &h->fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, h->fbo);
+  glGenRenderbuffers(1, &h->color);
+  glBindRenderbuffer(GL_RENDERBUFFER, h->color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, h->color);
+  glGenRenderbuffers(1, &h->depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, h->depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, h->depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    printf("Headless: %dx%d framebuffer is incomplete\n", width, height);
+    headless_close(h);
+    return 0;
+  }
+  glViewport(0, 0, width, height);
+  printf("Headless: %dx%d on %s\n", width, height,
+         (const char*)glGetString(GL_RENDERER));
+  return 1;
+}
+
+void headless_close(Headless* h) {
+  if (h->context) {
+    if (h->fbo) {
+      glDeleteFramebuffers(1, &h->fbo);
+      glDeleteRenderbuffers(1, &h->color);
+      glDeleteRenderbuffers(1, &h->depth);
+    }
+    eglMakeCurrent(h->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                   EGL_NO_CONTEXT);
+    eglDestroyContext(h->display, h->context);
+  }
+  if (h->surface) eglDestroySurface(h->display, h->surface);
+  if (h->display) eglTerminate(h->display);
+  memset(h, 0, sizeof(*h));
+}
@@ -0,0 +1,32 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// --- HEADLESS CONTEXT ---
+// An OpenGL 3.3 core context with no window and no display server, for CI
+// and render servers without a GPU: EGL on Mesa's surfaceless platform (or
+// the default display with a 1x1 pbuffer where that's missing), drawing
+// into an offscreen framebuffer of any size. Mesa's llvmpipe renders it on
+// the CPU. Only built where EGL is available (HAVE_EGL).
+
+typedef struct {
+  void* display;  // EGLDisplay
+  void* context;  // EGLContext
+  void* surface;  // EGLSurface, or EGL_NO_SURFACE when surfaceless
+  unsigned int fbo;
+  unsigned int color;  // RGBA8 renderbuffer
+  unsigned int depth;  // Depth/stencil renderbuffer
+  int width;
+  int height;
+} Headless;
+
+// Create the context, make it current, load the GL functions (glad) and
+// bind a width x height framebuffer for drawing and reading, with the
+// viewport set to match. Returns 0 and prints why on failure.
+int headless_open(Headless* h, int width, int height);
+
+// GL function lookup for loaders, like glfwGetProcAddress
+void* headless_proc_address(const char* name);
+
+void headless_close(Headless* h);
+
+#endif
@@ -0,0 +1,182 @@
+#include "meter.h"
+
+#include <math.h>
+#include <string.h>
+
+// Filter coefficients from BS.1770, rederived for any sample rate (the spec
+// only tabulates 48 kHz).
+static void k_weighting(Meter* m) {
+  double fs = m->sample_rate;
+
+  // Stage 1: high shelf, +4 dB above ~1.7 kHz (head diffraction)
+  double f0 = 1681.974450955533, gain_db = 3.999843853973347;
+  double q = 0.7071752369554196;
+  double k = tan(M_PI * f0 / fs);
+  double vh = pow(10.0, gain_db / 20.0);
+  double vb = pow(vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+  double* s = m->kcoef[0];
+  s[0] = (vh + vb * k / q + k * k) / a0;
+  s[1] = 2.0 * (k * k - vh) / a0;
+  s[2] = (vh - vb * k / q + k * k) / a0;
+  s[3] = 2.0 * (k * k - 1.0) / a0;
+  s[4] = (1.0 - k / q + k * k) / a0;
+
+  // Stage 2: RLB high pass at ~38 Hz
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan(M_PI * f0 / fs);
+  a0 = 1.0 + k / q + k * k;
+  double* h = m->kcoef[1];
+  h[0] = 1.0;
+  h[1] = -2.0;
+  h[2] = 1.0;
+  h[3] = 2.0 * (k * k - 1.0) / a0;
+  h[4] = (1.0 - k / q + k * k) / a0;
+}
+
+void meter_init(Meter* m, double sample_rate) {
+  memset(m, 0, sizeof(*m));
+  m->sample_rate = sample_rate;
+  k_weighting(m);
+  m->peak_fall = log(pow(10.0, -20.0 / 20.0)) / sample_rate;  // 20 dB/s
+  m->rms_tau = 0.3 * sample_rate;
+  m->block_len = (int)(0.1 * sample_rate);
+  m->min_gain = 1.0f;
+
+  m->back = 0;
+  m->front = 1;
+  atomic_init(&m->middle, 2u);
+  for (int i = 0; i < 3; i++) {
+    m->slots[i].peak_db = METER_FLOOR_DB;
+    m->slots[i].rms_db = METER_FLOOR_DB;
+    m->slots[i].short_lufs = METER_FLOOR_DB;
+  }
+}
+
+// Direct form II transposed biquad
+static inline double biquad(const double* c, double* z, double x) {
+  double y = c[0] * x + z[0];
+  z[0] = c[1] * x - c[3] * y + z[1];
+  z[1] = c[2] * x - c[4] * y;
+  return y;
+}
+
+// Close a 100 ms loudness block into the short-term ring.
+static void end_block(Meter* m) {
+  double e = m->block_sum / m->block_len;
+  m->st_sum += e - m->st_ring[m->st_pos];
+  m->st_ring[m->st_pos] = e;
+  m->st_pos = (m->st_pos + 1) % METER_ST_BLOCKS;
+  if (m->st_count < METER_ST_BLOCKS) m->st_count++;
+  m->block_sum = 0.0;
+  m->block_fill = 0;
+}
+
+static bool filters_settled(const Meter* m) {
+  return m->kstate[0][0] == 0.0 && m->kstate[0][1] == 0.0 &&
+         m->kstate[1][0] == 0.0 && m->kstate[1][1] == 0.0;
+}
+
+void meter_process(Meter* m, const float* buf, int n, bool silent) {
+  if (silent && filters_settled(m)) {
+    // Zero energy in: decay the detectors and step the loudness blocks
+    m->peak = (float)(m->peak * exp(m->peak_fall * n));
+    m->mean_sq *= exp(-n / m->rms_tau);
+    for (int left = n; left > 0;) {
+      int take = m->block_len - m->block_fill;
+      if (take > left) take = left;
+      m->block_fill += take;
+      left -= take;
+      if (m->block_fill == m->block_len) end_block(m);
+    }
+    m->frames += n;
+    return;
+  }
+
+  // 1. Peak and energy: lane-wise max / sum so the reductions vectorise
+  // (a single float accumulator would pin the loop to scalar order).
+  float pk[METER_LANES] = {0}, sq[METER_LANES] = {0};
+  int i = 0;
+  for (; i + METER_LANES <= n; i += METER_LANES) {
+    for (int l = 0; l < METER_LANES; l++) {
+      float x = buf[i + l];
+      float a = fabsf(x);
+      pk[l] = a > pk[l] ? a : pk[l];
+      sq[l] += x * x;
+    }
+  }
+  for (; i < n; i++) {
+    float a = fabsf(buf[i]);
+    pk[0] = a > pk[0] ? a : pk[0];
+    sq[0] += buf[i] * buf[i];
+  }
+  float peak = 0.0f;
+  double sum = 0.0;
+  for (int l = 0; l < METER_LANES; l++) {
+    peak = pk[l] > peak ? pk[l] : peak;
+    sum += sq[l];
+  }
+
+  // Peak hold falls back at a fixed dB rate; RMS is a one-pole per block
+  m->peak = (float)(m->peak * exp(m->peak_fall * n));
+  if (peak > m->peak) m->peak = peak;
+  m->mean_sq += (sum / n - m->mean_sq) * (1.0 - exp(-n / m->rms_tau));
+
+  // 2. Loudness: K-weighting is recursive, so this part stays scalar
+  for (int j = 0; j < n; j++) {
+    double y = biquad(m->kcoef[0], m->kstate[0], buf[j]);
+    y = biquad(m->kcoef[1], m->kstate[1], y);
+    m->block_sum += y * y;
+
+    if (++m->block_fill == m->block_len) end_block(m);
+  }
+  // Over silence the filter state decays into denormals, which are slow on
+  // x86; flush it to zero instead
+  for (int s = 0; s < 2; s++)
+    for (int z = 0; z < 2; z++)
+      if (fabs(m->kstate[s][z]) < 1e-30) m->kstate[s][z] = 0.0;
+  m->frames += n;
+}
+
+void meter_note_gain(Meter* m, float gain) {
+  if (gain < m->min_gain) m->min_gain = gain;
+}
+
+static float to_db(double power_ratio) {
+  if (power_ratio <= 1e-7) return METER_FLOOR_DB;
+  float db = (float)(10.0 * log10(power_ratio));
+  return db < METER_FLOOR_DB ? METER_FLOOR_DB : db;
+}
+
+void meter_publish(Meter* m) {
+  MeterReading* r = &m->slots[m->back];
+  r->peak_db = to_db((double)m->peak * m->peak);
+  r->rms_db = to_db(m->mean_sq);
+  r->short_lufs = METER_FLOOR_DB;
+  if (m->st_count > 0) {
+    // Mono: channel weight 1, plus the spec's -0.691 dB offset
+    float lufs = -0.691f + to_db(m->st_sum / m->st_count);
+    r->short_lufs = lufs < METER_FLOOR_DB ? METER_FLOOR_DB : lufs;
+  }
+  r->reduction_db = 20.0f * log10f(1.0f / m->min_gain);
+  r->frames = m->frames;
+  m->min_gain = 1.0f;
+
+  // Swap our finished slot into the middle and take the old middle back
+  unsigned old = atomic_exchange_explicit(&m->middle, m->back | METER_FRESH,
+                                          memory_order_acq_rel);
+  m->back = old & 3u;
+}
+
+bool meter_read(Meter* m, MeterReading* out) {
+  bool fresh = false;
+  if (atomic_load_explicit(&m->middle, memory_order_relaxed) & METER_FRESH) {
+    unsigned old = atomic_exchange_explicit(&m->middle, m->front,
+                                            memory_order_acq_rel);
+    m->front = old & 3u;
+    fresh = true;
+  }
+  *out = m->slots[m->front];
+  return fresh;
+}
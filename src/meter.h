@@ -0,0 +1,80 @@
+#ifndef METER_H
+#define METER_H
+
+// --- OUTPUT METERING ---
+// Level meters for the master bus, cheap enough to leave on for a whole
+// show. The audio thread folds every block into sample peak (with a falling
+// hold), 300 ms RMS and ITU-R BS.1770 short-term loudness (K-weighted,
+// 3 s window), then publishes a reading once per callback through a triple
+// buffer. The render loop picks up the newest reading without ever waiting
+// on the audio thread (and without a lock).
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define METER_LANES 8        // Accumulators per reduction (vector width)
+#define METER_FLOOR_DB -70.0f  // What silence reads as
+#define METER_ST_BLOCKS 30   // Short-term window in 100 ms loudness blocks
+
+typedef struct {
+  float peak_db;       // dBFS, holds then falls at 20 dB/s
+  float rms_db;        // dBFS over ~300 ms
+  float short_lufs;    // Short-term loudness (LUFS)
+  float reduction_db;  // Deepest limiter gain reduction since last reading
+  long long frames;    // Audio sample clock when published
+} MeterReading;
+
+typedef struct {
+  double sample_rate;
+
+  // K-weighting: high shelf then high pass (b0 b1 b2 a1 a2)
+  double kcoef[2][5];
+  double kstate[2][2];
+
+  float peak;       // Linear, with fall-back
+  double peak_fall;  // ln(per-sample fall factor)
+  double mean_sq;   // RMS detector
+  double rms_tau;   // In samples
+
+  // Loudness: 100 ms blocks of K-weighted energy in a 3 s ring
+  double block_sum;
+  int block_len;
+  int block_fill;
+  double st_ring[METER_ST_BLOCKS];
+  double st_sum;
+  int st_pos;
+  int st_count;
+
+  float min_gain;  // Limiter gain since the last publish
+  long long frames;
+
+  // Triple buffer: the audio thread writes slots[back], the render loop
+  // reads slots[front], and they swap through `middle`.
+  MeterReading slots[3];
+  _Atomic unsigned middle;  // Slot index, | METER_FRESH when unread
+  unsigned back;
+  unsigned front;
+} Meter;
+
+#define METER_FRESH 4u
+
+void meter_init(Meter* m, double sample_rate);
+
+// --- AUDIO THREAD ---
+// Measure n samples of the output. With `silent` set (buf is all zeros)
+// the reductions are skipped and, once the filters have settled, only the
+// clocks advance.
+void meter_process(Meter* m, const float* buf, int n, bool silent);
+
+// Report the limiter's gain (linear) for the reduction meter.
+void meter_note_gain(Meter* m, float gain);
+
+// Hand the current values to the render loop. Once per callback.
+void meter_publish(Meter* m);
+
+// --- RENDER THREAD ---
+// Copies the newest published reading to `out`. Returns false if nothing
+// new has been published since the last call (out still gets the latest).
+bool meter_read(Meter* m, MeterReading* out);
+
+#endif
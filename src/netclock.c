@@ -0,0 +1,344 @@
+#include "netclock.h"
+
+#include <arpa/inet.h>
+#include <math.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAGIC 0x44434C4Bu  // "DCLK"
+#define TYPE_PING 1u
+#define TYPE_PONG 2u
+#define PACKET_BYTES 56
+
+#define FAST_PERIOD_NS 25000000LL   // 25 ms while locking
+#define SLOW_PERIOD_NS 250000000LL  // 4 Hz once locked
+#define MIN_DRIFT_SPAN_NS 2000000000LL  // Don't fit drift over < 2 s
+#define MAX_DRIFT 500e-6                // Any real crystal is well inside
+
+long long netclock_mono_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// --- WIRE FORMAT ---
+// magic, type, seq, pad (u32 each), then t1 t2 t3 epoch (i64) and tempo
+// (f64 bits), all big-endian so mixed hosts agree.
+typedef struct {
+  uint32_t type;
+  uint32_t seq;
+  long long t1, t2, t3;
+  long long epoch_ns;
+  double tempo;
+} Packet;
+
+static void put32(unsigned char* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (24 - 8 * i));
+}
+
+static void put64(unsigned char* p, uint64_t v) {
+  put32(p, (uint32_t)(v >> 32));
+  put32(p + 4, (uint32_t)v);
+}
+
+static uint32_t get32(const unsigned char* p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+         (uint32_t)p[3];
+}
+
+static uint64_t get64(const unsigned char* p) {
+  return (uint64_t)get32(p) << 32 | get32(p + 4);
+}
+
+static void encode(unsigned char* b, const Packet* pk) {
+  put32(b, MAGIC);
+  put32(b + 4, pk->type);
+  put32(b + 8, pk->seq);
+  put32(b + 12, 0);
+  put64(b + 16, (uint64_t)pk->t1);
+  put64(b + 24, (uint64_t)pk->t2);
+  put64(b + 32, (uint64_t)pk->t3);
+  put64(b + 40, (uint64_t)pk->epoch_ns);
+  uint64_t bits;
+  memcpy(&bits, &pk->tempo, sizeof(bits));
+  put64(b + 48, bits);
+}
+
+static int decode(const unsigned char* b, int len, Packet* pk) {
+  if (len != PACKET_BYTES || get32(b) != MAGIC) return 0;
+  pk->type = get32(b + 4);
+  pk->seq = get32(b + 8);
+  pk->t1 = (long long)get64(b + 16);
+  pk->t2 = (long long)get64(b + 24);
+  pk->t3 = (long long)get64(b + 32);
+  pk->epoch_ns = (long long)get64(b + 40);
+  uint64_t bits = get64(b + 48);
+  memcpy(&pk->tempo, &bits, sizeof(bits));
+  return 1;
+}
+
+// --- ESTIMATE HAND-OFF ---
+static void clock_init(NetClock* nc, NetClockRole role, double tempo) {
+  memset(nc, 0, sizeof(*nc));
+  nc->role = role;
+  nc->fd = -1;
+  nc->now = netclock_mono_ns;
+  nc->tempo = tempo;
+  nc->back = 0;
+  nc->front = 1;
+  atomic_init(&nc->middle, 2u);
+  atomic_init(&nc->running, false);
+}
+
+static void publish(NetClock* nc, const NetClockEstimate* e) {
+  nc->slots[nc->back] = *e;
+  unsigned old = atomic_exchange_explicit(
+      &nc->middle, nc->back | NETCLOCK_FRESH, memory_order_acq_rel);
+  nc->back = old & 3u;
+}
+
+// Leader and solo clocks are the timeline, so the estimate is the identity
+static void publish_identity(NetClock* nc) {
+  NetClockEstimate e = {
+      .base_local = nc->epoch_ns,
+      .epoch_ns = nc->epoch_ns,
+      .tempo = nc->tempo,
+      .locked = true,
+  };
+  // Fill every slot so the first read is valid whatever the reader holds
+  for (int i = 0; i < 3; i++) nc->slots[i] = e;
+  publish(nc, &e);
+}
+
+bool netclock_read(NetClock* nc, NetClockEstimate* out) {
+  bool fresh = false;
+  if (atomic_load_explicit(&nc->middle, memory_order_relaxed) &
+      NETCLOCK_FRESH) {
+    unsigned old = atomic_exchange_explicit(&nc->middle, nc->front,
+                                            memory_order_acq_rel);
+    nc->front = old & 3u;
+    fresh = true;
+  }
+  *out = nc->slots[nc->front];
+  return fresh;
+}
+
+// --- CONVERSIONS ---
+long long netclock_to_leader(const NetClockEstimate* e, long long local_ns) {
+  double since = (double)(local_ns - e->base_local);
+  return local_ns + e->offset_ns + llround(e->drift * since);
+}
+
+long long netclock_to_local(const NetClockEstimate* e, long long leader_ns) {
+  // Invert leader = local + offset + drift * (local - base)
+  double x = (double)(leader_ns - e->offset_ns - e->base_local);
+  return e->base_local + llround(x / (1.0 + e->drift));
+}
+
+double netclock_ticks(const NetClockEstimate* e, long long local_ns) {
+  return (double)(netclock_to_leader(e, local_ns) - e->epoch_ns) * 1e-9 *
+         e->tempo;
+}
+
+long long netclock_tick_local(const NetClockEstimate* e, long long tick) {
+  long long leader = e->epoch_ns + llround((double)tick * 1e9 / e->tempo);
+  return netclock_to_local(e, leader);
+}
+
+// --- FOLLOWER FILTER ---
+static int cmp_ll(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
+
+// Fit offset and drift through the window's fastest exchanges
+static void refit(NetClock* nc) {
+  long long delays[NETCLOCK_WINDOW];
+  for (int i = 0; i < nc->count; i++) delays[i] = nc->window[i].delay;
+  qsort(delays, (size_t)nc->count, sizeof(long long), cmp_ll);
+  long long cutoff = delays[(nc->count - 1) / 2];
+
+  // Reference point: the newest exchange, so the fit is centred on now
+  const NetClockSample* ref =
+      &nc->window[(nc->next + NETCLOCK_WINDOW - 1) % NETCLOCK_WINDOW];
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  long long first = ref->local_mid, best_delay = delays[0];
+  long long best_offset = ref->offset;
+  int n = 0;
+  for (int i = 0; i < nc->count; i++) {
+    const NetClockSample* s = &nc->window[i];
+    if (s->delay > cutoff) continue;
+    double x = (double)(s->local_mid - ref->local_mid);
+    double y = (double)(s->offset - ref->offset);
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+    if (s->local_mid < first) first = s->local_mid;
+    if (s->delay == best_delay) best_offset = s->offset;
+    n++;
+  }
+
+  NetClockEstimate e = {
+      .base_local = ref->local_mid,
+      .delay_ns = best_delay,
+      .epoch_ns = nc->epoch_ns,
+      .tempo = nc->tempo,
+      .exchanges = n,
+      .locked = nc->count >= NETCLOCK_MIN_LOCK,
+  };
+  double var = n * sxx - sx * sx;
+  if (ref->local_mid - first >= MIN_DRIFT_SPAN_NS && var > 0.0) {
+    double b = (n * sxy - sx * sy) / var;
+    if (b > MAX_DRIFT) b = MAX_DRIFT;
+    if (b < -MAX_DRIFT) b = -MAX_DRIFT;
+    double a = (sy - b * sx) / n;  // Offset at the reference, relative
+    e.offset_ns = ref->offset + llround(a);
+    e.drift = b;
+  } else {
+    // Too little history for a slope: trust the cleanest single exchange
+    e.offset_ns = best_offset;
+  }
+  publish(nc, &e);
+}
+
+static void add_exchange(NetClock* nc, const Packet* pk, long long t4) {
+  NetClockSample* s = &nc->window[nc->next];
+  s->local_mid = pk->t1 + (t4 - pk->t1) / 2;
+  s->offset = ((pk->t2 - pk->t1) + (pk->t3 - t4)) / 2;
+  s->delay = (t4 - pk->t1) - (pk->t3 - pk->t2);
+  if (s->delay < 0) s->delay = 0;
+  nc->next = (nc->next + 1) % NETCLOCK_WINDOW;
+  if (nc->count < NETCLOCK_WINDOW) nc->count++;
+  nc->epoch_ns = pk->epoch_ns;
+  nc->tempo = pk->tempo;
+  refit(nc);
+}
+
+// --- THREADS ---
+static void* leader_main(void* arg) {
+  NetClock* nc = (NetClock*)arg;
+  struct pollfd pfd = {.fd = nc->fd, .events = POLLIN};
+  unsigned char buf[PACKET_BYTES + 4];
+
+  while (atomic_load_explicit(&nc->running, memory_order_acquire)) {
+    if (poll(&pfd, 1, 100) <= 0) continue;
+    struct sockaddr_in from;
+    socklen_t flen = sizeof(from);
+    ssize_t n = recvfrom(nc->fd, buf, sizeof(buf), 0, (struct sockaddr*)&from,
+                         &flen);
+    long long t2 = nc->now();
+    Packet pk;
+    if (n <= 0 || !decode(buf, (int)n, &pk) || pk.type != TYPE_PING) continue;
+
+    pk.type = TYPE_PONG;
+    pk.t2 = t2;
+    pk.epoch_ns = nc->epoch_ns;
+    pk.tempo = nc->tempo;
+    pk.t3 = nc->now();  // As late as possible before the send
+    encode(buf, &pk);
+    sendto(nc->fd, buf, PACKET_BYTES, 0, (struct sockaddr*)&from, flen);
+    nc->pongs++;
+  }
+  return NULL;
+}
+
+static void* follower_main(void* arg) {
+  NetClock* nc = (NetClock*)arg;
+  struct pollfd pfd = {.fd = nc->fd, .events = POLLIN};
+  unsigned char buf[PACKET_BYTES + 4];
+  long long next_ping = netclock_mono_ns();
+
+  while (atomic_load_explicit(&nc->running, memory_order_acquire)) {
+    long long mono = netclock_mono_ns();
+    if (mono >= next_ping) {
+      Packet pk = {.type = TYPE_PING, .seq = nc->seq++};
+      pk.t1 = nc->now();
+      encode(buf, &pk);
+      sendto(nc->fd, buf, PACKET_BYTES, 0, (struct sockaddr*)&nc->leader,
+             sizeof(nc->leader));
+      nc->pings++;
+      next_ping += nc->pings < NETCLOCK_FAST_PINGS ? FAST_PERIOD_NS
+                                                   : SLOW_PERIOD_NS;
+      if (next_ping < mono) next_ping = mono;  // Don't burst after a stall
+    }
+
+    int wait_ms = (int)((next_ping - mono) / 1000000) + 1;
+    if (poll(&pfd, 1, wait_ms) <= 0) continue;
+    ssize_t n = recv(nc->fd, buf, sizeof(buf), 0);
+    long long t4 = nc->now();
+    Packet pk;
+    if (n <= 0 || !decode(buf, (int)n, &pk) || pk.type != TYPE_PONG) continue;
+    // Ignore anything we didn't ask for recently
+    if (nc->seq - pk.seq > NETCLOCK_WINDOW) continue;
+    nc->pongs++;
+    add_exchange(nc, &pk, t4);
+  }
+  return NULL;
+}
+
+static int start(NetClock* nc, void* (*fn)(void*)) {
+  atomic_store(&nc->running, true);
+  if (pthread_create(&nc->thread, NULL, fn, nc) != 0) {
+    atomic_store(&nc->running, false);
+    close(nc->fd);
+    nc->fd = -1;
+    return 0;
+  }
+  return 1;
+}
+
+static int resolve(struct sockaddr_in* addr, const char* host, int port) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sin_family = AF_INET;
+  addr->sin_port = htons((uint16_t)port);
+  return inet_pton(AF_INET, host, &addr->sin_addr) == 1;
+}
+
+void netclock_solo(NetClock* nc, double tempo) {
+  clock_init(nc, NETCLOCK_SOLO, tempo);
+  nc->epoch_ns = nc->now();
+  publish_identity(nc);
+}
+
+int netclock_lead(NetClock* nc, const char* host, int port, double tempo) {
+  clock_init(nc, NETCLOCK_LEADER, tempo);
+  nc->epoch_ns = nc->now();
+  publish_identity(nc);
+
+  struct sockaddr_in addr;
+  if (!resolve(&addr, host, port)) return 0;
+  nc->fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (nc->fd < 0) return 0;
+  int one = 1;
+  setsockopt(nc->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (bind(nc->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(nc->fd);
+    nc->fd = -1;
+    return 0;
+  }
+  socklen_t alen = sizeof(addr);
+  getsockname(nc->fd, (struct sockaddr*)&addr, &alen);
+  nc->port = ntohs(addr.sin_port);
+  return start(nc, leader_main);
+}
+
+int netclock_follow(NetClock* nc, const char* host, int port,
+                    long long (*now)(void)) {
+  clock_init(nc, NETCLOCK_FOLLOWER, 0.0);
+  if (now) nc->now = now;
+  if (!resolve(&nc->leader, host, port)) return 0;
+  nc->fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (nc->fd < 0) return 0;
+  return start(nc, follower_main);
+}
+
+void netclock_close(NetClock* nc) {
+  if (atomic_exchange(&nc->running, false)) pthread_join(nc->thread, NULL);
+  if (nc->fd >= 0) close(nc->fd);
+  nc->fd = -1;
+}
@@ -0,0 +1,118 @@
+#ifndef NETCLOCK_H
+#define NETCLOCK_H
+
+// --- NETWORK CLOCK SYNC ---
+// Keeps several engine instances on one musical timeline. One instance
+// leads: its clock defines the show timeline (beat 0 at `epoch_ns`, `tempo`
+// ticks per second) and it answers timing pings over UDP. Followers ping the
+// leader a few times a second and estimate, NTP-style, the offset between
+// their clock and the leader's from each four-timestamp exchange:
+//
+//   offset = ((t2 - t1) + (t3 - t4)) / 2     delay = (t4 - t1) - (t3 - t2)
+//
+// Exchanges that took longer than the window's median are dropped (they
+// carry queueing noise), and a straight-line fit through the rest gives the
+// offset plus the drift between the two crystals. The result reaches the
+// render loop through a triple buffer, so reading it never waits on the
+// network thread.
+//
+// All times are nanoseconds on each host's monotonic clock.
+
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NETCLOCK_WINDOW 64      // Exchanges kept for the fit
+#define NETCLOCK_MIN_LOCK 8     // Exchanges before the estimate is trusted
+#define NETCLOCK_FAST_PINGS 16  // Quick pings at startup to lock sooner
+
+typedef enum {
+  NETCLOCK_SOLO,      // No network: the local clock is the timeline
+  NETCLOCK_LEADER,
+  NETCLOCK_FOLLOWER,
+} NetClockRole;
+
+// The follower's view of the leader, as of base_local:
+//   leader_time(local) = local + offset_ns + drift * (local - base_local)
+typedef struct {
+  long long base_local;
+  long long offset_ns;
+  double drift;        // Leader seconds gained per local second
+  long long delay_ns;  // Best round trip in the window
+  long long epoch_ns;  // Beat 0, on the leader's clock
+  double tempo;        // Ticks per second
+  int exchanges;       // Used in this fit
+  bool locked;
+} NetClockEstimate;
+
+// One measured exchange
+typedef struct {
+  long long local_mid;  // (t1 + t4) / 2
+  long long offset;
+  long long delay;
+} NetClockSample;
+
+typedef struct {
+  NetClockRole role;
+  int fd;
+  int port;                   // Leader's bound port (port 0 picks one)
+  struct sockaddr_in leader;  // Followers only
+  long long (*now)(void);     // Local clock (tests can skew it)
+
+  long long epoch_ns;  // Leader's timeline, as announced
+  double tempo;
+
+  // Follower filter state (network thread only)
+  NetClockSample window[NETCLOCK_WINDOW];
+  int count;
+  int next;
+  uint32_t seq;
+  unsigned long long pings;
+  unsigned long long pongs;
+
+  // Triple buffer: the network thread writes slots[back], the reader
+  // takes slots[front], and they swap through `middle`.
+  NetClockEstimate slots[3];
+  _Atomic unsigned middle;  // Slot index, | NETCLOCK_FRESH when unread
+  unsigned back;
+  unsigned front;
+
+  pthread_t thread;
+  atomic_bool running;
+} NetClock;
+
+#define NETCLOCK_FRESH 4u
+
+long long netclock_mono_ns(void);
+
+// Local timeline starting now; no thread, no socket.
+void netclock_solo(NetClock* nc, double tempo);
+
+// Lead the timeline (beat 0 is now) and answer pings on host:port. The
+// timeline is valid even if binding fails.
+int netclock_lead(NetClock* nc, const char* host, int port, double tempo);
+
+// Follow the leader at host:port. The estimate is unlocked until enough
+// exchanges have come back. `now` is the local clock (NULL for the
+// monotonic clock; tests pass a skewed one).
+int netclock_follow(NetClock* nc, const char* host, int port,
+                    long long (*now)(void));
+
+// Stops the thread and closes the socket.
+void netclock_close(NetClock* nc);
+
+// Newest estimate (any one reader thread). Returns true if it changed.
+bool netclock_read(NetClock* nc, NetClockEstimate* out);
+
+// Conversions through an estimate
+long long netclock_to_leader(const NetClockEstimate* e, long long local_ns);
+long long netclock_to_local(const NetClockEstimate* e, long long leader_ns);
+
+// Beat position (in ticks, fractional) at a local time, and the local time
+// at which tick k falls.
+double netclock_ticks(const NetClockEstimate* e, long long local_ns);
+long long netclock_tick_local(const NetClockEstimate* e, long long tick);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+// --- PARALLEL OFFLINE RENDERING ---
+// A long set is cut into time segments that worker threads render at the
+// same time. Each segment starts from a snapshot of the complete synth state
+// (voice phases, envelope position, sequencer clock, RNG) at its boundary.
+// The snapshots come from a cheap state-only pass (synth_advance skips all
+// the sin/exp work), so the stitched result is bit-identical to a serial
+// render.
+
+#include <stdint.h>
+
+#include "synth.h"
+
+// Everything needed to resume rendering at a given sample, bit-exactly.
+typedef struct {
+  AudioState fm;
+  SynthSeq seq;
+} SynthSnapshot;
+
+typedef struct {
+  double scan_sec;    // State-only pass that produces the snapshots
+  double render_sec;  // Parallel DSP
+  int segments;
+  int threads;
+} OfflineStats;
+
+// Start of a seeded set rendered at `sample_rate`.
+void offline_snapshot_init(SynthSnapshot* snap, uint32_t seed,
+                           double sample_rate);
+
+// Render `frames` samples from `start` on a single thread (the reference).
+void offline_render_serial(const SynthSnapshot* start, int16_t* out,
+                           long long frames);
+
+// Same output as offline_render_serial, split into `segments` pieces that
+// `threads` workers render concurrently. Returns 0 on failure.
+int offline_render_parallel(const SynthSnapshot* start, int16_t* out,
+                            long long frames, int segments, int threads,
+                            OfflineStats* stats);
+
+#endif
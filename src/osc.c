@@ -0,0 +1,413 @@
+#include "osc.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Everything in OSC is big-endian and padded to 4 bytes
+static int pad4(int n) { return (n + 3) & ~3; }
+
+static uint32_t rd_be32(const char* p) {
+  const unsigned char* u = (const unsigned char*)p;
+  return (uint32_t)u[0] << 24 | (uint32_t)u[1] << 16 | (uint32_t)u[2] << 8 |
+         (uint32_t)u[3];
+}
+
+static uint64_t rd_be64(const char* p) {
+  return (uint64_t)rd_be32(p) << 32 | rd_be32(p + 4);
+}
+
+static void wr_be32(char* p, uint32_t v) {
+  p[0] = (char)(v >> 24);
+  p[1] = (char)(v >> 16);
+  p[2] = (char)(v >> 8);
+  p[3] = (char)v;
+}
+
+// A padded, NUL-terminated string starting at off. Returns the offset just
+// past its padding, or -1 if it runs off the end of the buffer.
+static int read_string(const char* buf, int len, int off, const char** out) {
+  const char* end = memchr(buf + off, '\0', (size_t)(len - off));
+  if (!end) return -1;
+  int next = off + pad4((int)(end - (buf + off)) + 1);
+  if (next > len) return -1;
+  *out = buf + off;
+  return next;
+}
+
+int osc_parse_message(const char* buf, int len, OscMessage* msg) {
+  if (len < 4 || len % 4 != 0 || buf[0] != '/') return 0;
+  int off = read_string(buf, len, 0, &msg->address);
+  if (off < 0) return 0;
+  msg->argc = 0;
+  msg->types = "";
+  if (off == len) return 1;  // Old-style message with no type tag
+
+  const char* tags;
+  off = read_string(buf, len, off, &tags);
+  if (off < 0 || tags[0] != ',') return 0;
+  msg->types = tags + 1;
+
+  for (const char* t = msg->types; *t; t++) {
+    if (msg->argc == OSC_MAX_ARGS) return 0;
+    OscArg* a = &msg->args[msg->argc++];
+    a->type = *t;
+    a->blob_len = 0;
+    switch (*t) {
+      case 'i':
+      case 'f':
+        if (off + 4 > len) return 0;
+        uint32_t w = rd_be32(buf + off);
+        if (*t == 'i') {
+          a->i = (int32_t)w;
+        } else {
+          memcpy(&a->f, &w, sizeof(float));
+        }
+        off += 4;
+        break;
+      case 'h':
+      case 'd':
+        if (off + 8 > len) return 0;
+        uint64_t q = rd_be64(buf + off);
+        if (*t == 'h') {
+          a->h = (int64_t)q;
+        } else {
+          memcpy(&a->d, &q, sizeof(double));
+        }
+        off += 8;
+        break;
+      case 's':
+      case 'S':
+        off = read_string(buf, len, off, &a->s);
+        if (off < 0) return 0;
+        a->type = 's';
+        break;
+      case 'b':
+        if (off + 4 > len) return 0;
+        uint32_t blen = rd_be32(buf + off);
+        // Bound it before padding, which would overflow near 2^31
+        if (blen > (uint32_t)(len - off - 4)) return 0;
+        a->blob_len = (int)blen;
+        if (off + 4 + pad4(a->blob_len) > len) return 0;
+        a->s = buf + off + 4;
+        off += 4 + pad4(a->blob_len);
+        break;
+      case 'T':
+      case 'F':
+      case 'N':
+      case 'I':
+        break;  // No payload
+      default:
+        return 0;  // Unknown tag: can't know its size, so can't go on
+    }
+  }
+  return 1;
+}
+
+static int parse_element(const char* buf, int len, int depth,
+                         void (*fn)(const OscMessage*, void*), void* ud) {
+  if (len >= 8 && memcmp(buf, "#bundle", 8) == 0) {
+    if (depth > 4 || len < 16) return -1;
+    int total = 0;
+    // Skip the 8-byte time tag; each element is a size then its contents
+    for (int off = 16; off < len;) {
+      if (off + 4 > len) return -1;
+      int size = (int)rd_be32(buf + off);
+      off += 4;
+      if (size <= 0 || size % 4 != 0 || size > len - off) return -1;
+      int n = parse_element(buf + off, size, depth + 1, fn, ud);
+      if (n < 0) return -1;
+      total += n;
+      off += size;
+    }
+    return total;
+  }
+
+  OscMessage msg;
+  if (!osc_parse_message(buf, len, &msg)) return -1;
+  fn(&msg, ud);
+  return 1;
+}
+
+int osc_parse_packet(const char* buf, int len,
+                     void (*fn)(const OscMessage* msg, void* ud), void* ud) {
+  return parse_element(buf, len, 0, fn, ud);
+}
+
+float osc_arg_float(const OscArg* arg) {
+  switch (arg->type) {
+    case 'i':
+      return (float)arg->i;
+    case 'f':
+      return arg->f;
+    case 'h':
+      return (float)arg->h;
+    case 'd':
+      return (float)arg->d;
+    case 'T':
+      return 1.0f;
+    default:
+      return 0.0f;
+  }
+}
+
+// Append a padded string; returns the new offset or -1 if it won't fit
+static int put_string(char* buf, int cap, int off, const char* str) {
+  int n = (int)strlen(str) + 1;
+  if (off + pad4(n) > cap) return -1;
+  memcpy(buf + off, str, (size_t)n);
+  memset(buf + off + n, 0, (size_t)(pad4(n) - n));
+  return off + pad4(n);
+}
+
+int osc_build_args(char* buf, int cap, const char* address,
+                   const OscArg* args, int argc) {
+  if (argc > OSC_MAX_ARGS) return 0;
+  int off = put_string(buf, cap, 0, address);
+  if (off < 0) return 0;
+
+  // Type tag string: ',' then one character per argument
+  char tags[OSC_MAX_ARGS + 2] = ",";
+  for (int k = 0; k < argc; k++) tags[k + 1] = args[k].type;
+  tags[argc + 1] = '\0';
+  off = put_string(buf, cap, off, tags);
+  if (off < 0) return 0;
+
+  for (int k = 0; k < argc; k++) {
+    const OscArg* a = &args[k];
+    if (a->type == 's') {
+      off = put_string(buf, cap, off, a->s);
+      if (off < 0) return 0;
+      continue;
+    }
+    if (off + 4 > cap) return 0;
+    uint32_t w;
+    if (a->type == 'i') {
+      w = (uint32_t)a->i;
+    } else if (a->type == 'f') {
+      memcpy(&w, &a->f, sizeof(w));
+    } else {
+      return 0;
+    }
+    wr_be32(buf + off, w);
+    off += 4;
+  }
+  return off;
+}
+
+int osc_build(char* buf, int cap, const char* address, const char* types,
+              ...) {
+  OscArg args[OSC_MAX_ARGS];
+  int argc = 0;
+  va_list ap;
+  va_start(ap, types);
+  for (const char* t = types; *t && argc < OSC_MAX_ARGS; t++) {
+    OscArg* a = &args[argc++];
+    a->type = *t;
+    if (*t == 'i') {
+      a->i = va_arg(ap, int);
+    } else if (*t == 'f') {
+      a->f = (float)va_arg(ap, double);
+    } else if (*t == 's') {
+      a->s = va_arg(ap, const char*);
+    } else {
+      argc = -1;
+      break;
+    }
+  }
+  va_end(ap);
+  if (argc < 0 || types[argc] != '\0') return 0;
+  return osc_build_args(buf, cap, address, args, argc);
+}
+
+// --- EVENT RINGS ---
+void osc_queue_init(OscQueue* q) {
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+}
+
+static bool queue_push(OscQueue* q, const OscEvent* ev) {
+  unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  if (head - tail >= OSC_QUEUE_CAP) return false;
+  q->ev[head & (OSC_QUEUE_CAP - 1)] = *ev;
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+  return true;
+}
+
+bool osc_queue_pop(OscQueue* q, OscEvent* out) {
+  unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+  if (tail == head) return false;
+  *out = q->ev[tail & (OSC_QUEUE_CAP - 1)];
+  atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// --- LATENCY ---
+long long osc_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void osc_latency_note(OscLatency* lat, long long recv_ns, long long now_ns) {
+  long long d = now_ns - recv_ns;
+  if (d < 0) d = 0;
+  lat->count++;
+  lat->sum_ns += d;
+  if (d > lat->max_ns) lat->max_ns = d;
+
+  // Power-of-two microsecond buckets: cheap enough for the audio thread
+  long long us = d / 1000;
+  int k = 0;
+  while (k < OSC_LAT_BUCKETS - 1 && us >= (1LL << k)) k++;
+  lat->buckets[k]++;
+}
+
+double osc_latency_percentile(const OscLatency* lat, double p) {
+  if (lat->count == 0) return 0.0;
+  long long want = (long long)(p * (double)lat->count);
+  if (want >= lat->count) want = lat->count - 1;
+  long long seen = 0;
+  for (int k = 0; k < OSC_LAT_BUCKETS; k++) {
+    seen += lat->buckets[k];
+    if (seen > want) return (double)(1LL << k);  // Bucket's upper edge
+  }
+  return (double)(1LL << (OSC_LAT_BUCKETS - 1));
+}
+
+void osc_latency_print(const OscLatency* lat, const char* label) {
+  if (lat->count == 0) {
+    printf("OSC %s: no events\n", label);
+    return;
+  }
+  printf("OSC %s: %lld events, mean %.1f us, p50 < %.0f us, p99 < %.0f us, "
+         "max %.1f us\n",
+         label, lat->count, lat->sum_ns / 1000.0 / (double)lat->count,
+         osc_latency_percentile(lat, 0.50), osc_latency_percentile(lat, 0.99),
+         lat->max_ns / 1000.0);
+}
+
+// --- SERVER ---
+int osc_open(OscServer* s, const char* host, int port) {
+  memset(s, 0, sizeof(*s));
+  s->fd = -1;
+  atomic_init(&s->packets, 0);
+  atomic_init(&s->messages, 0);
+  atomic_init(&s->malformed, 0);
+  atomic_init(&s->unrouted, 0);
+  atomic_init(&s->dropped, 0);
+  atomic_init(&s->parse_ns, 0);
+  atomic_init(&s->running, false);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)port);
+  if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) return 0;
+
+  s->fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (s->fd < 0) return 0;
+  int one = 1;
+  setsockopt(s->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (bind(s->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(s->fd);
+    s->fd = -1;
+    return 0;
+  }
+  socklen_t alen = sizeof(addr);
+  getsockname(s->fd, (struct sockaddr*)&addr, &alen);
+  s->port = ntohs(addr.sin_port);
+  return 1;
+}
+
+int osc_route(OscServer* s, const char* address, int tag, int id,
+              OscQueue* queue) {
+  if (s->num_routes >= OSC_MAX_ROUTES ||
+      strlen(address) >= sizeof(s->routes[0].address))
+    return 0;
+  OscRoute* r = &s->routes[s->num_routes++];
+  strcpy(r->address, address);
+  r->tag = tag;
+  r->id = id;
+  r->queue = queue;
+  return 1;
+}
+
+// Turn one parsed message into an event on its route's ring
+static void dispatch(const OscMessage* msg, void* ud) {
+  OscServer* s = (OscServer*)ud;
+  atomic_fetch_add_explicit(&s->messages, 1, memory_order_relaxed);
+
+  const OscRoute* r = NULL;
+  for (int i = 0; i < s->num_routes; i++) {
+    if (strcmp(s->routes[i].address, msg->address) == 0) {
+      r = &s->routes[i];
+      break;
+    }
+  }
+  if (!r) {
+    atomic_fetch_add_explicit(&s->unrouted, 1, memory_order_relaxed);
+    return;
+  }
+
+  OscEvent ev = {.tag = r->tag, .id = r->id, .recv_ns = s->recv_ns};
+  for (int i = 0; i < msg->argc && ev.count < OSC_EVENT_VALUES; i++) {
+    char t = msg->args[i].type;
+    if (t == 's' || t == 'b' || t == 'N' || t == 'I') continue;
+    ev.v[ev.count++] = osc_arg_float(&msg->args[i]);
+  }
+  if (!queue_push(r->queue, &ev)) {
+    atomic_fetch_add_explicit(&s->dropped, 1, memory_order_relaxed);
+  }
+}
+
+static void* server_main(void* arg) {
+  OscServer* s = (OscServer*)arg;
+  struct pollfd pfd = {.fd = s->fd, .events = POLLIN};
+
+  while (atomic_load_explicit(&s->running, memory_order_acquire)) {
+    // Wake up now and then to notice osc_close
+    if (poll(&pfd, 1, 100) <= 0) continue;
+    ssize_t n = recv(s->fd, s->packet, sizeof(s->packet), 0);
+    if (n <= 0) continue;
+
+    s->recv_ns = osc_now_ns();
+    atomic_fetch_add_explicit(&s->packets, 1, memory_order_relaxed);
+    if (osc_parse_packet(s->packet, (int)n, dispatch, s) < 0) {
+      atomic_fetch_add_explicit(&s->malformed, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&s->parse_ns, osc_now_ns() - s->recv_ns,
+                              memory_order_relaxed);
+  }
+  return NULL;
+}
+
+int osc_start(OscServer* s) {
+  atomic_store(&s->running, true);
+  if (pthread_create(&s->thread, NULL, server_main, s) != 0) {
+    atomic_store(&s->running, false);
+    return 0;
+  }
+  return 1;
+}
+
+void osc_close(OscServer* s) {
+  if (atomic_exchange(&s->running, false)) pthread_join(s->thread, NULL);
+  if (s->fd >= 0) close(s->fd);
+  s->fd = -1;
+
+  unsigned long long packets = atomic_load(&s->packets);
+  printf("OSC: %llu packets, %llu messages (%llu malformed packets, %llu "
+         "unrouted, %llu dropped), %.2f us parse+dispatch per packet\n",
+         packets, atomic_load(&s->messages), atomic_load(&s->malformed),
+         atomic_load(&s->unrouted), atomic_load(&s->dropped),
+         packets ? atomic_load(&s->parse_ns) / 1000.0 / (double)packets : 0.0);
+}
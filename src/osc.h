@@ -0,0 +1,148 @@
+#ifndef OSC_H
+#define OSC_H
+
+// --- OSC CONTROL SURFACE ---
+// Open Sound Control over UDP, so controllers and other software can play
+// notes and move parameters while the show runs. A server thread receives
+// packets, parses them in place (no allocation: arguments point into the
+// receive buffer), and turns every message whose address has a route into
+// a small OscEvent. Events go to the audio or render thread through
+// single-producer/single-consumer rings, so neither thread ever waits on
+// the network. Each event carries its receive time; the consumer folds
+// receive-to-dequeue latency into an OscLatency histogram.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OSC_MAX_ARGS 8
+#define OSC_PACKET_MAX 8192   // Largest datagram we accept
+#define OSC_QUEUE_CAP 1024    // Events per ring (power of two)
+#define OSC_MAX_ROUTES 64
+#define OSC_EVENT_VALUES 4    // Numeric arguments carried per event
+#define OSC_LAT_BUCKETS 24    // Latency histogram: bucket k is < 2^k us
+
+// --- MESSAGES ---
+typedef struct {
+  char type;  // OSC type tag: 'i', 'f', 's', 'h', 'd', 'T', 'F', 'N', 'b'
+  union {
+    int32_t i;
+    float f;
+    int64_t h;
+    double d;
+    const char* s;  // Points into the packet
+  };
+  int blob_len;  // 'b' only; s points at the data
+} OscArg;
+
+typedef struct {
+  const char* address;
+  const char* types;  // Without the leading ','
+  int argc;
+  OscArg args[OSC_MAX_ARGS];
+} OscMessage;
+
+// Parse one message in place. Returns 0 on a malformed message or one with
+// more than OSC_MAX_ARGS arguments.
+int osc_parse_message(const char* buf, int len, OscMessage* msg);
+
+// Walk a packet (a message or a possibly nested #bundle), calling fn for
+// every message. Bundle time tags are ignored: contents apply on arrival.
+// Returns the number of messages, or -1 if any part was malformed.
+int osc_parse_packet(const char* buf, int len,
+                     void (*fn)(const OscMessage* msg, void* ud), void* ud);
+
+// Numeric argument as a float (ints, doubles, T/F); 0 for anything else.
+float osc_arg_float(const OscArg* arg);
+
+// Build a message from argc 'i', 'f' or 's' arguments into buf. Returns
+// the size, or 0 if it doesn't fit.
+int osc_build_args(char* buf, int cap, const char* address,
+                   const OscArg* args, int argc);
+
+// Same, with one vararg per tag in types: 'i' takes an int, 'f' a double,
+// 's' a const char*.
+int osc_build(char* buf, int cap, const char* address, const char* types,
+              ...);
+
+// --- EVENT RINGS ---
+typedef struct {
+  int tag;        // What the route says this is (the app's own enum)
+  int id;         // Route-specific id (e.g. a parameter id)
+  int count;      // Numeric values present
+  float v[OSC_EVENT_VALUES];
+  long long recv_ns;  // When the packet arrived (osc_now_ns clock)
+} OscEvent;
+
+typedef struct {
+  OscEvent ev[OSC_QUEUE_CAP];
+  _Atomic unsigned head;  // Next slot the server writes
+  _Atomic unsigned tail;  // Next event the consumer reads
+} OscQueue;
+
+void osc_queue_init(OscQueue* q);
+
+// Consumer side: lock- and allocation-free. Returns false when empty.
+bool osc_queue_pop(OscQueue* q, OscEvent* out);
+
+// Receive-to-consume latency, kept by the consumer. Read it only once the
+// consumer has stopped (or accept slightly stale numbers).
+typedef struct {
+  long long count;
+  long long sum_ns;
+  long long max_ns;
+  long long buckets[OSC_LAT_BUCKETS];
+} OscLatency;
+
+long long osc_now_ns(void);
+void osc_latency_note(OscLatency* lat, long long recv_ns, long long now_ns);
+// Approximate percentile (0..1) in microseconds, from the histogram.
+double osc_latency_percentile(const OscLatency* lat, double p);
+void osc_latency_print(const OscLatency* lat, const char* label);
+
+// --- SERVER ---
+typedef struct {
+  char address[64];
+  int tag;
+  int id;
+  OscQueue* queue;
+} OscRoute;
+
+typedef struct {
+  int fd;
+  int port;  // Bound port (useful when opened on port 0)
+
+  OscRoute routes[OSC_MAX_ROUTES];
+  int num_routes;
+
+  // Counters (server thread writes, anyone reads)
+  _Atomic unsigned long long packets;
+  _Atomic unsigned long long messages;
+  _Atomic unsigned long long malformed;  // Packets that failed to parse
+  _Atomic unsigned long long unrouted;   // Messages with no route
+  _Atomic unsigned long long dropped;    // Events lost to a full ring
+  _Atomic long long parse_ns;            // Total time spent parsing
+
+  long long recv_ns;  // Arrival time of the packet being dispatched
+  char packet[OSC_PACKET_MAX];
+
+  pthread_t thread;
+  atomic_bool running;
+} OscServer;
+
+// Bind a UDP socket on host:port (port 0 picks a free one). Add routes
+// before osc_start.
+int osc_open(OscServer* s, const char* host, int port);
+
+// Send messages at `address` to `queue` as events with this tag and id.
+// Returns 0 when the route table is full.
+int osc_route(OscServer* s, const char* address, int tag, int id,
+              OscQueue* queue);
+
+int osc_start(OscServer* s);
+
+// Stops the thread, closes the socket and prints the counters.
+void osc_close(OscServer* s);
+
+#endif
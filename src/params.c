@@ -0,0 +1,156 @@
+#include "params.h"
+
+#include <math.h>
+#include <string.h>
+
+void params_init(ParamBank* pb, double sample_rate) {
+  memset(pb, 0, sizeof(*pb));
+  pb->sample_rate = sample_rate;
+  for (int w = 0; w < PARAM_MAX / 64; w++) atomic_init(&pb->dirty[w], 0);
+  atomic_init(&pb->ev_head, 0);
+  atomic_init(&pb->ev_tail, 0);
+  atomic_init(&pb->clock, 0);
+}
+
+static float clampf(float x, float lo, float hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+int params_add(ParamBank* pb, float initial, float min, float max,
+               ParamSmooth mode, double smooth_sec) {
+  if (pb->count >= PARAM_MAX) return -1;
+  int id = pb->count++;
+  Param* p = &pb->params[id];
+  p->min = min;
+  p->max = max;
+  p->mode = mode;
+  p->smooth_sec = smooth_sec;
+  p->value = p->goal = clampf(initial, min, max);
+  atomic_init(&p->target, p->value);
+
+  // Fraction of the remaining distance left after one slice
+  double tau = smooth_sec * pb->sample_rate;
+  p->default_decay = tau > 0.0 ? (float)exp(-PARAM_SLICE / tau) : 0.0f;
+  p->slice_decay = p->default_decay;
+  return id;
+}
+
+void params_set(ParamBank* pb, int id, float target) {
+  if (id < 0 || id >= pb->count) return;
+  Param* p = &pb->params[id];
+  atomic_store_explicit(&p->target, clampf(target, p->min, p->max),
+                        memory_order_relaxed);
+  // Release pairs with the audio thread's acquire on the dirty word, so it
+  // always sees the target that goes with the bit
+  atomic_fetch_or_explicit(&pb->dirty[id / 64], 1ull << (id % 64),
+                           memory_order_release);
+}
+
+int params_schedule(ParamBank* pb, int id, long long time, float value,
+                    float ramp_sec) {
+  if (id < 0 || id >= pb->count) return 0;
+  unsigned head = atomic_load_explicit(&pb->ev_head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&pb->ev_tail, memory_order_acquire);
+  if (head - tail >= PARAM_EVENT_CAP) return 0;
+
+  const Param* p = &pb->params[id];
+  ParamEvent* e = &pb->events[head & (PARAM_EVENT_CAP - 1)];
+  e->time = time;
+  e->value = clampf(value, p->min, p->max);
+  e->ramp_sec = ramp_sec;
+  e->id = id;
+  atomic_store_explicit(&pb->ev_head, head + 1, memory_order_release);
+  return 1;
+}
+
+long long params_clock(ParamBank* pb) {
+  return atomic_load_explicit(&pb->clock, memory_order_relaxed);
+}
+
+int params_until_event(ParamBank* pb, int n) {
+  unsigned tail = atomic_load_explicit(&pb->ev_tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&pb->ev_head, memory_order_acquire);
+  if (tail == head) return n;
+  long long due = pb->events[tail & (PARAM_EVENT_CAP - 1)].time - pb->pos;
+  // A due (or overdue) event is applied by params_begin at the block start
+  if (due <= 0 || due >= n) return n;
+  return (int)due;
+}
+
+// Point a parameter at a new goal, gliding over ramp_sec (or its default).
+static void retarget(ParamBank* pb, int id, float goal, double ramp_sec) {
+  Param* p = &pb->params[id];
+  p->goal = goal;
+  if (p->mode == PARAM_LINEAR) {
+    if (ramp_sec < 0.0) ramp_sec = p->smooth_sec;
+    int len = (int)(ramp_sec * pb->sample_rate);
+    if (len < 1) len = 1;
+    p->ramp_left = len;
+    p->step = (goal - p->value) / (float)len;
+  } else if (ramp_sec >= 0.0) {
+    double tau = ramp_sec * pb->sample_rate;
+    p->slice_decay = tau > 0.0 ? (float)exp(-PARAM_SLICE / tau) : 0.0f;
+  } else {
+    p->slice_decay = p->default_decay;
+  }
+  pb->active[id / 64] |= 1ull << (id % 64);
+}
+
+void params_begin(ParamBank* pb) {
+  // Lane events whose sample has arrived
+  unsigned tail = atomic_load_explicit(&pb->ev_tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&pb->ev_head, memory_order_acquire);
+  while (tail != head) {
+    const ParamEvent* e = &pb->events[tail & (PARAM_EVENT_CAP - 1)];
+    if (e->time > pb->pos) break;
+    retarget(pb, e->id, e->value, e->ramp_sec);
+    tail++;
+  }
+  atomic_store_explicit(&pb->ev_tail, tail, memory_order_release);
+
+  // Targets the control thread has touched since the last block
+  for (int w = 0; w < PARAM_MAX / 64; w++) {
+    if (atomic_load_explicit(&pb->dirty[w], memory_order_relaxed) == 0)
+      continue;
+    uint64_t bits =
+        atomic_exchange_explicit(&pb->dirty[w], 0, memory_order_acquire);
+    while (bits) {
+      int id = w * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+      float t = atomic_load_explicit(&pb->params[id].target,
+                                     memory_order_relaxed);
+      if (t != pb->params[id].goal) retarget(pb, id, t, -1.0);
+    }
+  }
+}
+
+void params_advance(ParamBank* pb, int n) {
+  for (int w = 0; w < PARAM_MAX / 64; w++) {
+    uint64_t bits = pb->active[w];
+    while (bits) {
+      int bit = __builtin_ctzll(bits);
+      bits &= bits - 1;
+      Param* p = &pb->params[w * 64 + bit];
+      int done;
+
+      if (p->mode == PARAM_LINEAR) {
+        p->ramp_left -= n;
+        p->value += p->step * (float)n;
+        done = p->ramp_left <= 0;
+      } else {
+        float decay = n == PARAM_SLICE
+                          ? p->slice_decay
+                          : powf(p->slice_decay, (float)n / PARAM_SLICE);
+        p->value = p->goal + (p->value - p->goal) * decay;
+        // Settle once the rest of the glide is below float resolution
+        done = fabsf(p->value - p->goal) <= 1e-6f * (p->max - p->min);
+      }
+      if (done) {
+        p->value = p->goal;
+        pb->active[w] &= ~(1ull << bit);
+      }
+    }
+  }
+  pb->pos += n;
+  atomic_store_explicit(&pb->clock, pb->pos, memory_order_relaxed);
+}
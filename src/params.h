@@ -0,0 +1,103 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+// --- LOCK-FREE PARAMETER AUTOMATION ---
+// Anything the control thread wants to move while the audio is running
+// (volume, FM index, modulator ratio, ...) is a Param. The control thread
+// only ever stores an atomic target and sets a dirty bit; the audio thread
+// picks dirty targets up at the start of a block and glides towards them
+// every PARAM_SLICE samples, so changes never click and never need a lock.
+//
+// Only dirty or still-gliding parameters are touched per block (bitmask
+// scan), so registering hundreds of them costs nothing while they're idle.
+//
+// Automation lanes: events can also be scheduled on the audio sample clock.
+// They go through a single-producer ring in time order, and the audio
+// thread splits its blocks so each one lands on its exact sample.
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define PARAM_MAX 256
+#define PARAM_SLICE 64  // Control-rate step in samples (~1.5 ms)
+#define PARAM_EVENT_CAP 1024  // Pending lane events (power of two)
+
+typedef enum {
+  PARAM_LINEAR,  // Straight ramp that arrives after smooth_sec
+  PARAM_EXP,     // One-pole glide with time constant smooth_sec
+} ParamSmooth;
+
+typedef struct {
+  _Atomic float target;  // Written by the control thread
+  float value;           // Current smoothed value (audio thread)
+  float goal;            // What value is gliding towards (audio thread)
+  float step;            // PARAM_LINEAR: increment per sample
+  int ramp_left;         // PARAM_LINEAR: samples until goal
+  float slice_decay;     // PARAM_EXP: remaining distance after a slice
+  float default_decay;   // PARAM_EXP: slice_decay for smooth_sec
+  float min, max;
+  double smooth_sec;
+  ParamSmooth mode;
+} Param;
+
+// One scheduled point on an automation lane.
+typedef struct {
+  long long time;  // Audio sample clock
+  float value;
+  float ramp_sec;  // Glide length; < 0 uses the parameter's own smoothing
+  int id;
+} ParamEvent;
+
+typedef struct {
+  Param params[PARAM_MAX];
+  int count;
+  double sample_rate;
+
+  _Atomic uint64_t dirty[PARAM_MAX / 64];  // Set by params_set
+  uint64_t active[PARAM_MAX / 64];         // Still gliding (audio thread)
+
+  // Automation lane ring (control thread pushes, audio thread pops)
+  ParamEvent events[PARAM_EVENT_CAP];
+  _Atomic unsigned ev_head;  // Next slot the control thread writes
+  _Atomic unsigned ev_tail;  // Next event the audio thread applies
+
+  long long pos;            // Sample clock (audio thread)
+  _Atomic long long clock;  // pos, published for the control thread
+} ParamBank;
+
+void params_init(ParamBank* pb, double sample_rate);
+
+// Register a parameter before the audio thread starts. Returns its id, or
+// -1 when the bank is full.
+int params_add(ParamBank* pb, float initial, float min, float max,
+               ParamSmooth mode, double smooth_sec);
+
+// --- CONTROL THREAD (no lock, any rate) ---
+void params_set(ParamBank* pb, int id, float target);
+
+// Queue a lane event for sample `time` on the audio clock. Events must be
+// scheduled in time order; events already in the past apply on the next
+// block. Returns 0 if the ring is full.
+int params_schedule(ParamBank* pb, int id, long long time, float value,
+                    float ramp_sec);
+
+// Audio sample clock as of the last rendered block.
+long long params_clock(ParamBank* pb);
+
+// --- AUDIO THREAD ---
+// How many of the next n samples can be rendered before a lane event is
+// due; the caller splits its block there so the event is sample-accurate.
+int params_until_event(ParamBank* pb, int n);
+
+// Apply due lane events and freshly set targets. Call once per block.
+void params_begin(ParamBank* pb);
+
+// Move every gliding parameter n samples forward (n <= PARAM_SLICE for
+// smooth ramps) and advance the sample clock.
+void params_advance(ParamBank* pb, int n);
+
+static inline float params_get(const ParamBank* pb, int id) {
+  return pb->params[id].value;
+}
+
+#endif
@@ -0,0 +1,137 @@
+#include "perf.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// JSON keys, by series
+static const char* k_series_keys[PERF_SERIES] = {"frame_ms", "cpu_ms",
+                                                 "gpu_ms"};
+
+int perf_init(PerfLog* log, int capacity, double budget_ms) {
+  memset(log, 0, sizeof(*log));
+  if (capacity < 1) capacity = 1;
+  for (int s = 0; s < PERF_SERIES; s++) {
+    log->ms[s] = (float*)malloc(sizeof(float) * (size_t)capacity);
+    if (!log->ms[s]) {
+      perf_free(log);
+      return 0;
+    }
+  }
+  log->capacity = capacity;
+  log->budget_ms = budget_ms;
+  return 1;
+}
+
+void perf_free(PerfLog* log) {
+  for (int s = 0; s < PERF_SERIES; s++) free(log->ms[s]);
+  memset(log, 0, sizeof(*log));
+}
+
+void perf_add(PerfLog* log, PerfSeries series, double ms) {
+  if (log->count[series] >= log->capacity) return;
+  log->ms[series][log->count[series]++] = (float)ms;
+  if (series == PERF_FRAME && ms > log->budget_ms) log->over_budget++;
+}
+
+static int compare_floats(const void* a, const void* b) {
+  float x = *(const float*)a, y = *(const float*)b;
+  return (x > y) - (x < y);
+}
+
+// The smallest sample with at least p percent of them at or below it
+static double rank(const float* sorted, int n, double p) {
+  int k = (int)ceil(p / 100.0 * n) - 1;
+  return sorted[k < 0 ? 0 : k];
+}
+
+void perf_summary(const PerfLog* log, PerfSeries series, PerfSummary* out) {
+  memset(out, 0, sizeof(*out));
+  int n = log->count[series];
+  float* sorted = n > 0 ? (float*)malloc(sizeof(float) * (size_t)n) : NULL;
+  if (!sorted) return;
+  memcpy(sorted, log->ms[series], sizeof(float) * (size_t)n);
+  qsort(sorted, (size_t)n, sizeof(float), compare_floats);
+  out->count = n;
+  out->p50 = rank(sorted, n, 50.0);
+  out->p95 = rank(sorted, n, 95.0);
+  out->p99 = rank(sorted, n, 99.0);
+  out->max = sorted[n - 1];
+  free(sorted);
+}
+
+int perf_write_json(const PerfLog* log, const char* path, const char* setup) {
+  FILE* f = fopen(path, "w");
+  if (!f) return 0;
+  fprintf(f, "{\n  \"setup\": \"");
+  for (const char* c = setup; *c; c++) {
+    if (*c == '"' || *c == '\\') fputc('\\', f);
+    if ((unsigned char)*c >= 0x20) fputc(*c, f);
+  }
+  fprintf(f, "\",\n  \"budget_ms\": %.3f,\n  \"over_budget\": %d",
+          log->budget_ms, log->over_budget);
+  for (int s = 0; s < PERF_SERIES; s++) {
+    PerfSummary sum;
+    perf_summary(log, (PerfSeries)s, &sum);
+    fprintf(f,
+            ",\n  \"%s\": {\"count\": %d, \"p50\": %.4f, \"p95\": %.4f, "
+            "\"p99\": %.4f, \"max\": %.4f}",
+            k_series_keys[s], sum.count, sum.p50, sum.p95, sum.p99, sum.max);
+  }
+  fprintf(f, "\n}\n");
+  return fclose(f) == 0;
+}
+
+// `field` of the object under `key`, as written above. Returns 0 if absent.
+static int read_field(const char* json, const char* key, const char* field,
+                      double* out) {
+  char quoted[32];
+  snprintf(quoted, sizeof(quoted), "\"%s\"", key);
+  const char* obj = strstr(json, quoted);
+  const char* end = obj ? strchr(obj, '}') : NULL;
+  if (!end) return 0;
+  snprintf(quoted, sizeof(quoted), "\"%s\"", field);
+  const char* at = strstr(obj, quoted);
+  if (!at || at > end) return 0;
+  at = strchr(at + strlen(quoted), ':');
+  return at && sscanf(at + 1, "%lf", out) == 1;
+}
+
+int perf_compare(const PerfLog* log, const char* baseline_path,
+                 double threshold_pct) {
+  FILE* f = fopen(baseline_path, "r");
+  if (!f) return -1;
+  char json[4096];
+  size_t len = fread(json, 1, sizeof(json) - 1, f);
+  fclose(f);
+  json[len] = '\0';
+
+  static const char* fields[3] = {"p50", "p95", "p99"};
+  int regressed = 0, compared = 0;
+  printf("Against %s (fail above +%.0f%%):\n", baseline_path, threshold_pct);
+  for (int s = 0; s < PERF_SERIES; s++) {
+    PerfSummary sum;
+    perf_summary(log, (PerfSeries)s, &sum);
+    double base_count;
+    if (sum.count == 0 ||
+        !read_field(json, k_series_keys[s], "count", &base_count) ||
+        base_count < 1.0)
+      continue;
+    const double now[3] = {sum.p50, sum.p95, sum.p99};
+    for (int k = 0; k < 3; k++) {
+      double base;
+      if (!read_field(json, k_series_keys[s], fields[k], &base)) continue;
+      compared++;
+      double limit = base * (1.0 + threshold_pct / 100.0);
+      bool worse = now[k] > limit && now[k] - base > PERF_SLACK_MS;
+      printf("  %-8s %s %9.3f ms, was %9.3f (%+6.1f%%)%s\n", k_series_keys[s],
+             fields[k], now[k], base,
+             base > 0.0 ? (now[k] / base - 1.0) * 100.0 : 0.0,
+             worse ? "  REGRESSED" : "");
+      if (worse) regressed++;
+    }
+  }
+  return compared > 0 ? regressed : -1;
+}
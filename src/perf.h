@@ -0,0 +1,48 @@
+#ifndef PERF_H
+#define PERF_H
+
+// --- FRAME TIME RECORDS ---
+// What "--bench" measures, frame by frame: the frame time (swap to swap),
+// the CPU time spent building the frame, and the GPU time spent drawing it.
+// At the end each series is boiled down to percentiles, written to a small
+// JSON report, and optionally compared with an earlier report so a driver
+// or engine change that makes frames slower fails the run.
+
+typedef enum { PERF_FRAME, PERF_CPU, PERF_GPU, PERF_SERIES } PerfSeries;
+
+typedef struct {
+  int count;
+  double p50, p95, p99, max;  // Milliseconds
+} PerfSummary;
+
+typedef struct {
+  float* ms[PERF_SERIES];  // Samples in milliseconds
+  int count[PERF_SERIES];
+  int capacity;  // Per series; later samples are dropped
+  double budget_ms;
+  int over_budget;  // PERF_FRAME samples longer than budget_ms
+} PerfLog;
+
+// Room for `capacity` samples per series. Returns 0 if out of memory.
+int perf_init(PerfLog* log, int capacity, double budget_ms);
+void perf_free(PerfLog* log);
+
+void perf_add(PerfLog* log, PerfSeries series, double ms);
+
+// Nearest-rank percentiles; all zero for an empty series
+void perf_summary(const PerfLog* log, PerfSeries series, PerfSummary* out);
+
+// Write the summaries, the budget and `setup` (free text saying what was
+// run) as JSON. Returns 0 if the file couldn't be written.
+int perf_write_json(const PerfLog* log, const char* path, const char* setup);
+
+// Compare p50, p95 and p99 of every series with a report written earlier,
+// printing each. A value regresses when it's more than `threshold_pct`
+// percent and PERF_SLACK_MS above the baseline (the slack keeps tiny
+// timings from failing on noise). Returns how many regressed, or -1 if the
+// baseline couldn't be read.
+#define PERF_SLACK_MS 0.05
+int perf_compare(const PerfLog* log, const char* baseline_path,
+                 double threshold_pct);
+
+#endif
@@ -0,0 +1,176 @@
+#include "pluck.h"
+
+#include <math.h>
+#include <string.h>
+
+#define LINE_MASK (PLUCK_LINE_LEN - 1)
+#define LANES 8  // Strings per vector group, enough for AVX
+
+void pluck_init(PluckBank* pb, double sample_rate) {
+  memset(pb, 0, sizeof(*pb));
+  pb->sample_rate = sample_rate;
+  for (int s = 0; s < PLUCK_MAX_STRINGS; s++) {
+    pb->rng[s] = 0x9E3779B9u * (uint32_t)(s + 1);
+    pb->delay[s] = 2;
+    pb->exc_len[s] = 1;  // Spent excitation; keeps the hammer math finite
+    pb->exc_pos[s] = 1;
+  }
+}
+
+int pluck_trigger(PluckBank* pb, double freq, double velocity,
+                  double brightness, double sustain_sec, PluckExcite mode) {
+  if (freq < PLUCK_LOWEST_HZ || freq >= pb->sample_rate / 4.0) return -1;
+  // At high engine rates the lowest notes no longer fit the delay line
+  if (pb->sample_rate / freq >= PLUCK_LINE_LEN - 2) return -1;
+
+  // Prefer an idle string, otherwise steal the oldest
+  int s = 0;
+  for (int i = 0; i < PLUCK_MAX_STRINGS; i++) {
+    if (pb->life[i] <= 0) {
+      s = i;
+      break;
+    }
+    if (pb->age[i] < pb->age[s]) s = i;
+  }
+
+  // Loop delay P = N (line) + S (damping filter) + D (allpass), with D kept
+  // in [0.1, 1.1) where the first-order allpass has a flat phase delay.
+  double period = pb->sample_rate / freq;
+  double stretch = 0.5 * (1.0 - brightness);
+  if (stretch < 0.0) stretch = 0.0;
+  if (stretch > 0.5) stretch = 0.5;
+  int n = (int)floor(period - stretch - 0.1);
+  double frac = period - stretch - n;
+
+  // Per-period gain that reaches -60 dB after sustain_sec
+  double periods = sustain_sec * freq;
+  double decay = periods > 0.0 ? pow(10.0, -3.0 / periods) : 0.0;
+
+  pb->delay[s] = n;
+  pb->ap_coef[s] = (float)((1.0 - frac) / (1.0 + frac));
+  pb->stretch[s] = (float)stretch;
+  pb->decay[s] = (float)decay;
+  pb->gain[s] = 0.5f;
+  pb->ap_x1[s] = 0.0f;
+  pb->ap_y1[s] = 0.0f;
+  pb->struck[s] = mode == PLUCK_STRUCK ? 1.0f : 0.0f;
+  pb->exc_amp[s] = (float)velocity;
+  pb->exc_pos[s] = 0;
+  // A pluck fills one period with noise; a hammer is a short blip
+  pb->exc_len[s] = mode == PLUCK_STRUCK ? (n / 6 > 2 ? n / 6 : 2) : n;
+  // Until the tail is 80 dB down
+  pb->life[s] = (long)(sustain_sec * 4.0 / 3.0 * pb->sample_rate) + n;
+  pb->age[s] = ++pb->trigger_count;
+
+  // Clear whatever the previous note left in this string's column
+  for (int t = 0; t < PLUCK_LINE_LEN; t++) pb->line[t][s] = 0.0f;
+
+  int hi = (s / LANES + 1) * LANES;
+  if (hi > pb->active_hi) pb->active_hi = hi;
+  return s;
+}
+
+// Every time the shared write index wraps, each string has run for at least
+// one full period: retire the ones whose loop has decayed below audibility.
+static void retire_silent(PluckBank* pb, int hi) {
+  for (int s = 0; s < hi; s++) {
+    bool excited = pb->exc_pos[s] < pb->exc_len[s];
+    if (!excited && pb->peak[s] * pb->gain[s] < PLUCK_SILENCE) pb->life[s] = 0;
+    pb->peak[s] = 0.0f;
+  }
+}
+
+bool pluck_render(PluckBank* pb, float* out, int n) {
+  int hi = pb->active_hi;
+  if (hi == 0) {
+    memset(out, 0, sizeof(float) * (size_t)n);
+    return false;
+  }
+
+  float in[PLUCK_MAX_STRINGS];
+  float older[PLUCK_MAX_STRINGS];
+
+  for (int i = 0; i < n; i++) {
+    int w = pb->w;
+
+    // 1. Gather: each string reads its own distance back from the shared
+    // write index (the only per-string indexed access).
+    for (int s = 0; s < hi; s++) {
+      int r = (w - pb->delay[s]) & LINE_MASK;
+      in[s] = pb->line[r][s];
+      older[s] = pb->line[(r - 1) & LINE_MASK][s];
+    }
+
+    // 2. Filters across strings: straight-line float math on contiguous
+    // arrays, vectorised by the compiler.
+    float* restrict row = pb->line[w];
+    float acc[LANES] = {0};
+    for (int g = 0; g < hi; g += LANES) {
+      for (int k = 0; k < LANES; k++) {
+        int s = g + k;
+
+        // Damping: two-point weighted average (delay S) times loop gain
+        float st = pb->stretch[s];
+        float y = pb->decay[s] * ((1.0f - st) * in[s] + st * older[s]);
+
+        // Fractional delay: first-order allpass tunes between samples
+        float c = pb->ap_coef[s];
+        float ap = c * y + pb->ap_x1[s] - c * pb->ap_y1[s];
+        pb->ap_x1[s] = y;
+        pb->ap_y1[s] = ap;
+
+        // Excitation: noise burst or triangular hammer, fed into the loop
+        uint32_t x = pb->rng[s];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        pb->rng[s] = x;
+        float noise = (float)(int32_t)x * (1.0f / 2147483648.0f);
+        float len = (float)pb->exc_len[s];
+        float pos = (float)pb->exc_pos[s];
+        float tri = 1.0f - fabsf(2.0f * pos / len - 1.0f);
+        float live = pb->exc_pos[s] < pb->exc_len[s] ? 1.0f : 0.0f;
+        float str = pb->struck[s];
+        float exc = live * pb->exc_amp[s] * (str * tri + (1.0f - str) * noise);
+        pb->exc_pos[s] += pb->exc_pos[s] < pb->exc_len[s];
+
+        float v = ap + exc;
+        row[s] = v;
+        acc[k] += v * pb->gain[s];
+        float a = fabsf(v);
+        pb->peak[s] = a > pb->peak[s] ? a : pb->peak[s];
+      }
+    }
+
+    float sum = 0.0f;
+    for (int k = 0; k < LANES; k++) sum += acc[k];
+    out[i] = sum;
+    pb->w = (w + 1) & LINE_MASK;
+    if (pb->w == 0) retire_silent(pb, hi);
+  }
+
+  // Retire strings that have faded out and shrink the active range
+  int new_hi = 0;
+  for (int s = 0; s < hi; s++) {
+    if (pb->life[s] > 0) {
+      pb->life[s] -= n;
+      if (pb->life[s] > 0) new_hi = (s / LANES + 1) * LANES;
+    }
+  }
+  pb->active_hi = new_hi;
+  return true;
+}
+
+void pluck_mix(PluckBank* pb, int16_t* out, int n) {
+  float tmp[1024];
+  for (int off = 0; off < n; off += 1024) {
+    int m = n - off < 1024 ? n - off : 1024;
+    if (!pluck_render(pb, tmp, m)) continue;
+    for (int i = 0; i < m; i++) {
+      int mixed = out[off + i] + (int)(tmp[i] * 32767.0f);
+      if (mixed > 32767) mixed = 32767;
+      if (mixed < -32768) mixed = -32768;
+      out[off + i] = (int16_t)mixed;
+    }
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef PLUCK_H
+#define PLUCK_H
+
+// --- PHYSICAL-MODELLING STRINGS (KARPLUS-STRONG) ---
+// Each string is a delay line fed back through a damping filter and a
+// fractional-delay allpass that fine-tunes the pitch. All strings share one
+// preallocated pool laid out as [time][string]: every string writes at the
+// same index each sample, so the filter math runs across strings as plain
+// float arrays the compiler vectorises, and nothing is allocated per note.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PLUCK_MAX_STRINGS 64
+// Lowest supported note sets the delay-line length (A0 at 44.1 kHz needs
+// ~1604 samples; rounded up to a power of two so wrapping is a mask).
+#define PLUCK_LOWEST_HZ 27.5
+#define PLUCK_LINE_LEN 2048
+
+// A string is retired once its output stays under half an LSB of 16-bit
+// audio for a whole delay-line length (checked every PLUCK_LINE_LEN samples).
+#define PLUCK_SILENCE (1.0f / 65536.0f)
+
+typedef enum {
+  PLUCK_PLUCKED,  // Noise burst: guitar / harp style pluck
+  PLUCK_STRUCK,   // Short triangular hammer: mallet / piano-ish strike
+} PluckExcite;
+
+typedef struct {
+  // Delay-line pool: line[t][s] is string s at time index t
+  float line[PLUCK_LINE_LEN][PLUCK_MAX_STRINGS];
+  int w;  // Shared write index
+
+  // Per-string state, structure-of-arrays
+  int delay[PLUCK_MAX_STRINGS];      // Integer part of the loop delay
+  float ap_coef[PLUCK_MAX_STRINGS];  // Allpass coefficient (fractional part)
+  float stretch[PLUCK_MAX_STRINGS];  // Damping filter weight (0 = brightest)
+  float decay[PLUCK_MAX_STRINGS];    // Loop gain per period
+  float gain[PLUCK_MAX_STRINGS];     // Output level
+  float ap_x1[PLUCK_MAX_STRINGS];    // Allpass input memory
+  float ap_y1[PLUCK_MAX_STRINGS];    // Allpass output memory
+  float struck[PLUCK_MAX_STRINGS];   // 1.0 = hammer, 0.0 = noise
+  float exc_amp[PLUCK_MAX_STRINGS];
+  int exc_pos[PLUCK_MAX_STRINGS];  // Samples of excitation already fed in
+  int exc_len[PLUCK_MAX_STRINGS];
+  uint32_t rng[PLUCK_MAX_STRINGS];
+  long life[PLUCK_MAX_STRINGS];  // Samples until the string is inaudible
+  float peak[PLUCK_MAX_STRINGS];  // Loudest loop sample since the last check
+  unsigned age[PLUCK_MAX_STRINGS];
+
+  int active_hi;  // Strings at or above this index are all idle
+  unsigned trigger_count;
+  double sample_rate;
+} PluckBank;
+
+void pluck_init(PluckBank* pb, double sample_rate);
+
+// Excite a free (or the oldest) string. brightness 0..1 sets the damping,
+// sustain_sec the time to fade by 60 dB. Returns the string index or -1.
+// Audio thread only.
+int pluck_trigger(PluckBank* pb, double freq, double velocity,
+                  double brightness, double sustain_sec, PluckExcite mode);
+
+// Render n samples of all active strings into out (overwrites). Returns
+// false (after a plain memset) when every string is idle.
+bool pluck_render(PluckBank* pb, float* out, int n);
+
+// Render and mix into the 16-bit bus with saturation. Audio thread only.
+void pluck_mix(PluckBank* pb, int16_t* out, int n);
+
+#endif
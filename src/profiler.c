@@ -0,0 +1,164 @@
+#include "profiler.h"
+
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int prof_init(Profiler* p, const char* csv_path) {
+  memset(p, 0, sizeof(*p));
+  for (int s = 0; s < PROF_LAG; s++) {
+    p->slots[s].frame = -1;
+    glGenQueries(PROF_MAX_MARKS * 2, &p->slots[s].query[0][0]);
+  }
+  // Some implementations have timer queries but no timestamp counter
+  GLint bits = 0;
+  glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+  p->gpu = bits > 0;
+  if (!csv_path) return 1;
+  p->csv = fopen(csv_path, "w");
+  if (!p->csv) return 0;
+  fprintf(p->csv, "frame,zone,depth,cpu_ms,gpu_ms\n");
+  return 1;
+}
+
+void prof_free(Profiler* p) {
+  for (int s = 0; s < PROF_LAG; s++) {
+    glDeleteQueries(PROF_MAX_MARKS * 2, &p->slots[s].query[0][0]);
+  }
+  if (p->csv) fclose(p->csv);
+  memset(p, 0, sizeof(*p));
+}
+
+// Move a finished frame's times into the history (and the CSV)
+static long long collect(Profiler* p, ProfSlot* s) {
+  if (s->frame < 0) return -1;
+  int h = (int)(p->collected % PROF_HISTORY);
+  bool seen[PROF_MAX_ZONES] = {false};
+  for (int z = 0; z < p->zone_count; z++) {
+    p->zones[z].cpu_ms[h] = 0.0f;
+    p->zones[z].gpu_ms[h] = 0.0f;
+  }
+  for (int m = 0; m < s->marks; m++) {
+    if (s->cpu[m][1] < s->cpu[m][0]) continue;  // Never left
+    ProfZone* z = &p->zones[s->zone[m]];
+    seen[s->zone[m]] = true;
+    z->cpu_ms[h] += (float)((s->cpu[m][1] - s->cpu[m][0]) * 1e3);
+    if (!p->gpu) continue;
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(s->query[m][0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(s->query[m][1], GL_QUERY_RESULT, &end);
+    if (end > begin) z->gpu_ms[h] += (float)((double)(end - begin) * 1e-6);
+  }
+  if (p->csv) {
+    for (int z = 0; z < p->zone_count; z++) {
+      if (!seen[z]) continue;
+      fprintf(p->csv, "%lld,%s,%d,%.4f,%.4f\n", s->frame, p->zones[z].name,
+              p->zones[z].depth, p->zones[z].cpu_ms[h],
+              p->zones[z].gpu_ms[h]);
+    }
+  }
+  long long frame = s->frame;
+  s->frame = -1;
+  s->marks = 0;
+  if (p->current == s) p->current = NULL;
+  p->collected++;
+  return frame;
+}
+
+long long prof_frame_begin(Profiler* p, long long frame) {
+  ProfSlot* s = &p->slots[frame % PROF_LAG];
+  long long done = collect(p, s);
+  s->frame = frame;
+  p->current = s;
+  p->depth = 0;
+  return done;
+}
+
+long long prof_drain(Profiler* p) {
+  ProfSlot* oldest = NULL;
+  for (int s = 0; s < PROF_LAG; s++) {
+    ProfSlot* slot = &p->slots[s];
+    if (slot->frame >= 0 && (!oldest || slot->frame < oldest->frame)) {
+      oldest = slot;
+    }
+  }
+  return oldest ? collect(p, oldest) : -1;
+}
+
+int prof_zone(const Profiler* p, const char* name) {
+  for (int z = 0; z < p->zone_count; z++) {
+    if (strcmp(p->zones[z].name, name) == 0) return z;
+  }
+  return -1;
+}
+
+void prof_begin(Profiler* p, const char* name) {
+  int mark = -1;
+  ProfSlot* s = p->current;
+  int z = s ? prof_zone(p, name) : -1;
+  if (s && z < 0 && p->zone_count < PROF_MAX_ZONES) {
+    z = p->zone_count++;
+    memset(&p->zones[z], 0, sizeof(p->zones[z]));
+    p->zones[z].name = name;
+    p->zones[z].depth = p->depth;
+  }
+  if (z >= 0 && s->marks < PROF_MAX_MARKS) {
+    mark = s->marks++;
+    s->zone[mark] = z;
+    s->cpu[mark][0] = now_sec();
+    s->cpu[mark][1] = -1.0;
+    if (p->gpu) glQueryCounter(s->query[mark][0], GL_TIMESTAMP);
+  }
+  if (p->depth < PROF_MAX_DEPTH) p->open[p->depth] = mark;
+  p->depth++;
+}
+
+void prof_end(Profiler* p) {
+  if (p->depth == 0) return;
+  p->depth--;
+  int mark = p->depth < PROF_MAX_DEPTH ? p->open[p->depth] : -1;
+  ProfSlot* s = p->current;
+  if (mark < 0 || !s) return;
+  if (p->gpu) glQueryCounter(s->query[mark][1], GL_TIMESTAMP);
+  s->cpu[mark][1] = now_sec();
+}
+
+float prof_ms(const Profiler* p, int zone, int ago, bool gpu) {
+  if (zone < 0 || zone >= p->zone_count || ago < 0 || ago >= PROF_HISTORY ||
+      ago >= p->collected)
+    return 0.0f;
+  int h = (int)((p->collected - 1 - ago) % PROF_HISTORY);
+  return gpu ? p->zones[zone].gpu_ms[h] : p->zones[zone].cpu_ms[h];
+}
+
+double prof_average(const Profiler* p, int zone, bool gpu) {
+  int n = p->collected < PROF_HISTORY ? (int)p->collected : PROF_HISTORY;
+  if (n == 0) return 0.0;
+  double sum = 0.0;
+  for (int k = 0; k < n; k++) sum += prof_ms(p, zone, k, gpu);
+  return sum / n;
+}
+
+void prof_print(const Profiler* p) {
+  int n = p->collected < PROF_HISTORY ? (int)p->collected : PROF_HISTORY;
+  printf("Profile, last %d frames (ms):\n", n);
+  printf("  %-20s %8s %8s %8s %8s\n", "zone", "cpu avg", "cpu max",
+         "gpu avg", "gpu max");
+  for (int z = 0; z < p->zone_count; z++) {
+    float cpu_max = 0.0f, gpu_max = 0.0f;
+    for (int k = 0; k < n; k++) {
+      float c = prof_ms(p, z, k, false), g = prof_ms(p, z, k, true);
+      if (c > cpu_max) cpu_max = c;
+      if (g > gpu_max) gpu_max = g;
+    }
+    int indent = 2 * p->zones[z].depth;
+    printf("  %*s%-*s %8.3f %8.3f %8.3f %8.3f\n", indent, "", 20 - indent,
+           p->zones[z].name, prof_average(p, z, false), cpu_max,
+           prof_average(p, z, true), gpu_max);
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// --- FRAME PROFILER ---
+// Named zones, nested inside each other, timed on both sides: the CPU with
+// the monotonic clock, the GPU with a GL_TIMESTAMP query at each edge. A
+// frame's queries are only read PROF_LAG frames later, when the GPU is long
+// done with them, so profiling never stalls the pipeline. The CPU times
+// wait with them and the two are combined then.
+//
+// Every zone keeps its last PROF_HISTORY frames, for rolling averages and
+// the on-screen graph. Finished frames can also be appended to a CSV file,
+// one row per zone. Render thread only.
+
+#include <glad/glad.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define PROF_MAX_ZONES 16  // Distinct zone names
+#define PROF_MAX_MARKS 32  // Zones entered per frame
+#define PROF_MAX_DEPTH 8
+#define PROF_LAG 4         // Frames between timing a frame and reading it
+#define PROF_HISTORY 120   // Frames kept per zone
+
+typedef struct {
+  const char* name;  // As passed to prof_begin (kept, not copied)
+  int depth;         // Nesting depth the first time it was entered
+  float cpu_ms[PROF_HISTORY];
+  float gpu_ms[PROF_HISTORY];
+} ProfZone;
+
+// One frame's zones, waiting for its GPU results
+typedef struct {
+  long long frame;  // -1 when free
+  int marks;
+  int zone[PROF_MAX_MARKS];
+  double cpu[PROF_MAX_MARKS][2];  // Seconds, at entry and exit
+  GLuint query[PROF_MAX_MARKS][2];
+} ProfSlot;
+
+typedef struct {
+  ProfZone zones[PROF_MAX_ZONES];
+  int zone_count;
+  ProfSlot slots[PROF_LAG];
+  ProfSlot* current;  // The frame being timed
+  int open[PROF_MAX_DEPTH];  // Marks entered and not yet left
+  int depth;
+  bool gpu;  // GL_TIMESTAMP counts; otherwise GPU times stay 0
+  long long collected;  // Frames read back so far
+  FILE* csv;
+} Profiler;
+
+// Create the queries (needs a current context) and open `csv_path` for
+// per-frame rows if it isn't NULL. Returns 0 if the CSV couldn't be
+// opened; profiling still works.
+int prof_init(Profiler* p, const char* csv_path);
+void prof_free(Profiler* p);
+
+// Start timing frame `frame`, first reading back the frame that used its
+// slot PROF_LAG frames ago. Returns that frame's number, or -1 if none.
+long long prof_frame_begin(Profiler* p, long long frame);
+
+// Read back the oldest frame still in flight, waiting for the GPU if need
+// be (for shutdown). Returns its number, or -1 if none are left.
+long long prof_drain(Profiler* p);
+
+// Enter and leave a zone. Zones nest; a zone entered twice in a frame adds
+// up. `name` must stay valid (a string literal).
+void prof_begin(Profiler* p, const char* name);
+void prof_end(Profiler* p);
+
+// Zone index for `name`, or -1 if it hasn't been entered yet
+int prof_zone(const Profiler* p, const char* name);
+
+// Milliseconds spent in `zone` in the frame read back `ago` frames before
+// the latest (0: the latest), on the GPU or the CPU. 0 if not kept.
+float prof_ms(const Profiler* p, int zone, int ago, bool gpu);
+
+// Mean over the frames kept
+double prof_average(const Profiler* p, int zone, bool gpu);
+
+// Each zone's average and worst, as an indented table
+void prof_print(const Profiler* p);
+
+#endif
@@ -0,0 +1,43 @@
+#include "radix.h"
+
+#include <string.h>
+
+void radix_sort(uint64_t* keys, uint32_t* values, int n, uint64_t* key_tmp,
+                uint32_t* value_tmp) {
+  int counts[8][256] = {{0}};  // Per byte
+  for (int i = 0; i < n; i++) {
+    uint64_t k = keys[i];
+    for (int b = 0; b < 8; b++) counts[b][(k >> (8 * b)) & 0xFF]++;
+  }
+
+  uint64_t* src_keys = keys;
+  uint32_t* src_values = values;
+  uint64_t* dst_keys = key_tmp;
+  uint32_t* dst_values = value_tmp;
+  for (int b = 0; b < 8; b++) {
+    int* count = counts[b];
+    if (n == 0 || count[(src_keys[0] >> (8 * b)) & 0xFF] == n) continue;
+    // Counts to starting positions
+    int at = 0;
+    for (int d = 0; d < 256; d++) {
+      int c = count[d];
+      count[d] = at;
+      at += c;
+    }
+    for (int i = 0; i < n; i++) {
+      int to = count[(src_keys[i] >> (8 * b)) & 0xFF]++;
+      dst_keys[to] = src_keys[i];
+      dst_values[to] = src_values[i];
+    }
+    uint64_t* k = src_keys;
+    src_keys = dst_keys;
+    dst_keys = k;
+    uint32_t* v = src_values;
+    src_values = dst_values;
+    dst_values = v;
+  }
+  if (src_keys != keys) {
+    memcpy(keys, src_keys, sizeof(uint64_t) * (size_t)n);
+    memcpy(values, src_values, sizeof(uint32_t) * (size_t)n);
+  }
+}
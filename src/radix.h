@@ -0,0 +1,19 @@
+#ifndef RADIX_H
+#define RADIX_H
+
+// --- RADIX SORT ---
+// Least-significant-digit radix sort of 64-bit keys, each carrying a 32-bit
+// value along: one pass per byte, counting then scattering between the
+// arrays and a scratch pair. Every byte's counts come from a single read of
+// the keys, and a byte that's the same in every key is skipped, so keys
+// that only use their low bits only pay for those. Stable: equal keys keep
+// their order.
+
+#include <stdint.h>
+
+// Sort `n` keys ascending, and the values with them. `key_tmp` and
+// `value_tmp` are scratch space for `n` of each.
+void radix_sort(uint64_t* keys, uint32_t* values, int n, uint64_t* key_tmp,
+                uint32_t* value_tmp);
+
+#endif
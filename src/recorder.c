@@ -0,0 +1,217 @@
+#include "recorder.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+static void wr_le32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static void wr_le16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+// RIFF + fmt + JUNK padding + data header, exactly RECORDER_ALIGN bytes long
+// so that every PCM write after it lands on an aligned file offset.
+static void build_wav_header(uint8_t* h, const Recorder* r,
+                             uint64_t data_bytes) {
+  if (data_bytes > 0xFFFFFFFFull - RECORDER_ALIGN)
+    data_bytes = 0xFFFFFFFFull - RECORDER_ALIGN;  // 4 GB RIFF limit
+  const size_t junk = RECORDER_ALIGN - 12 - 24 - 8 - 8;
+
+  memset(h, 0, RECORDER_ALIGN);
+  memcpy(h, "RIFF", 4);
+  wr_le32(h + 4, (uint32_t)(RECORDER_ALIGN - 8 + data_bytes));
+  memcpy(h + 8, "WAVE", 4);
+
+  memcpy(h + 12, "fmt ", 4);
+  wr_le32(h + 16, 16);
+  wr_le16(h + 20, 1);  // PCM
+  wr_le16(h + 22, (uint16_t)r->channels);
+  wr_le32(h + 24, (uint32_t)r->sample_rate);
+  wr_le32(h + 28, (uint32_t)(r->sample_rate * r->channels * 2));
+  wr_le16(h + 32, (uint16_t)(r->channels * 2));
+  wr_le16(h + 34, 16);
+
+  memcpy(h + 36, "JUNK", 4);
+  wr_le32(h + 40, (uint32_t)junk);
+
+  uint8_t* d = h + 44 + junk;
+  memcpy(d, "data", 4);
+  wr_le32(d + 4, (uint32_t)data_bytes);
+}
+
+static bool write_all(int fd, const void* buf, size_t len) {
+  const uint8_t* p = (const uint8_t*)buf;
+  while (len > 0) {
+    ssize_t w = write(fd, p, len);
+    if (w <= 0) return false;
+    p += w;
+    len -= (size_t)w;
+  }
+  return true;
+}
+
+// Move up to RECORDER_CHUNK_SAMPLES from the ring to disk in one write.
+static size_t drain_chunk(Recorder* r, size_t avail) {
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  size_t n = avail < RECORDER_CHUNK_SAMPLES ? avail : RECORDER_CHUNK_SAMPLES;
+
+  // Copy out of the ring (possibly in two pieces) into the aligned buffer
+  size_t at = tail & (RECORDER_RING_SAMPLES - 1);
+  size_t first = RECORDER_RING_SAMPLES - at;
+  if (first > n) first = n;
+  size_t bytes;
+  if (r->format == RECORD_RAW_F32) {
+    float* f = (float*)r->staging;
+    for (size_t i = 0; i < n; i++) {
+      f[i] = r->ring[(at + i) & (RECORDER_RING_SAMPLES - 1)] / 32768.0f;
+    }
+    bytes = n * sizeof(float);
+  } else {
+    memcpy(r->staging, r->ring + at, first * sizeof(int16_t));
+    memcpy((int16_t*)r->staging + first, r->ring,
+           (n - first) * sizeof(int16_t));
+    bytes = n * sizeof(int16_t);
+  }
+
+  // Hand the ring space back before the (slow) write
+  atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+
+  if (!r->io_error && !write_all(r->fd, r->staging, bytes)) {
+    r->io_error = true;
+    fprintf(stderr, "Recorder: write failed, dropping further audio\n");
+  }
+  if (!r->io_error) atomic_fetch_add(&r->written, n);
+  return n;
+}
+
+static void* writer_main(void* arg) {
+  Recorder* r = (Recorder*)arg;
+  const struct timespec nap = {0, 20 * 1000 * 1000};
+
+  // Disk I/O must never compete with the audio or render threads
+#ifdef __linux__
+  setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+#elif defined(__APPLE__)
+  pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+
+  for (;;) {
+    bool running = atomic_load_explicit(&r->running, memory_order_acquire);
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    size_t avail = head - atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    // Batch: only write full chunks while live, flush the rest at the end
+    if (avail >= RECORDER_CHUNK_SAMPLES || (!running && avail > 0)) {
+      drain_chunk(r, avail);
+    } else if (!running) {
+      break;
+    } else {
+      nanosleep(&nap, NULL);
+    }
+  }
+  return NULL;
+}
+
+int recorder_open(Recorder* r, const char* path, RecordFormat format,
+                  int sample_rate, int channels) {
+  memset(r, 0, sizeof(*r));
+  r->format = format;
+  r->sample_rate = sample_rate;
+  r->channels = channels;
+  r->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (r->fd < 0) return 0;
+
+  size_t staging_bytes = RECORDER_CHUNK_SAMPLES * sizeof(float);
+  if (posix_memalign((void**)&r->ring, RECORDER_ALIGN,
+                     RECORDER_RING_SAMPLES * sizeof(int16_t)) != 0 ||
+      posix_memalign(&r->staging, RECORDER_ALIGN, staging_bytes) != 0) {
+    free(r->ring);
+    close(r->fd);
+    return 0;
+  }
+  // Touch the whole ring now so the audio thread never faults it in
+  memset(r->ring, 0, RECORDER_RING_SAMPLES * sizeof(int16_t));
+
+  if (format == RECORD_WAV_S16) {
+    // Placeholder header; sizes are patched in recorder_close()
+    build_wav_header((uint8_t*)r->staging, r, 0);
+    if (!write_all(r->fd, r->staging, RECORDER_ALIGN)) {
+      free(r->ring);
+      free(r->staging);
+      close(r->fd);
+      return 0;
+    }
+  }
+
+  atomic_init(&r->head, 0);
+  atomic_init(&r->tail, 0);
+  atomic_init(&r->overflows, 0);
+  atomic_init(&r->dropped, 0);
+  atomic_init(&r->written, 0);
+  atomic_store(&r->running, true);
+  if (pthread_create(&r->writer, NULL, writer_main, r) != 0) {
+    atomic_store(&r->running, false);
+    free(r->ring);
+    free(r->staging);
+    close(r->fd);
+    return 0;
+  }
+  return 1;
+}
+
+void recorder_push(Recorder* r, const int16_t* pcm, int n) {
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+  if (RECORDER_RING_SAMPLES - (head - tail) < (size_t)n) {
+    // Writer fell behind: drop the block rather than wait for it
+    atomic_fetch_add_explicit(&r->overflows, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&r->dropped, (unsigned long long)n,
+                              memory_order_relaxed);
+    return;
+  }
+
+  size_t at = head & (RECORDER_RING_SAMPLES - 1);
+  size_t first = RECORDER_RING_SAMPLES - at;
+  if (first > (size_t)n) first = (size_t)n;
+  memcpy(r->ring + at, pcm, first * sizeof(int16_t));
+  memcpy(r->ring, pcm + first, ((size_t)n - first) * sizeof(int16_t));
+
+  atomic_store_explicit(&r->head, head + (size_t)n, memory_order_release);
+}
+
+void recorder_close(Recorder* r) {
+  if (!r->ring) return;
+  if (atomic_exchange(&r->running, false)) pthread_join(r->writer, NULL);
+
+  unsigned long long written = atomic_load(&r->written);
+  if (r->format == RECORD_WAV_S16 && !r->io_error) {
+    build_wav_header((uint8_t*)r->staging, r, written * sizeof(int16_t));
+    if (pwrite(r->fd, r->staging, RECORDER_ALIGN, 0) != RECORDER_ALIGN)
+      r->io_error = true;
+  }
+  close(r->fd);
+
+  printf("Recorded %.1f s (%llu samples), %lu overflow(s), %llu dropped%s\n",
+         (double)written / (r->sample_rate * r->channels), written,
+         atomic_load(&r->overflows), atomic_load(&r->dropped),
+         r->io_error ? ", I/O ERROR" : "");
+
+  free(r->ring);
+  free(r->staging);
+  r->ring = NULL;
+}
@@ -0,0 +1,61 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+// --- OUTPUT RECORDING TAP ---
+// Captures exactly what the audio callback produced. The callback only copies
+// its block into a big single-producer/single-consumer ring; a low-priority
+// writer thread drains the ring to disk in large, page-aligned writes. If the
+// disk falls behind, the block is dropped and counted -- the audio thread
+// never waits on the recorder.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// 2^22 samples = 8 MB of 16-bit audio, about 95 s of mono at 44.1 kHz
+#define RECORDER_RING_SAMPLES (1u << 22)
+// Samples per disk write (256 KB of 16-bit PCM)
+#define RECORDER_CHUNK_SAMPLES (128 * 1024)
+// The WAV header is padded so PCM starts on this boundary in the file
+#define RECORDER_ALIGN 4096
+
+typedef enum {
+  RECORD_WAV_S16,  // 16-bit PCM WAV, bit-exact copy of the output
+  RECORD_RAW_F32,  // Headerless 32-bit float, for quick analysis tools
+} RecordFormat;
+
+typedef struct {
+  int16_t* ring;
+  _Atomic size_t head;  // Total samples pushed (audio thread)
+  _Atomic size_t tail;  // Total samples written (writer thread)
+
+  _Atomic unsigned long overflows;         // Blocks dropped
+  _Atomic unsigned long long dropped;      // Samples dropped
+  _Atomic unsigned long long written;      // Samples on disk
+
+  int fd;
+  RecordFormat format;
+  int sample_rate;
+  int channels;
+  void* staging;  // Page-aligned bounce buffer for the writer
+  bool io_error;
+
+  pthread_t writer;
+  atomic_bool running;
+} Recorder;
+
+// Creates the file, allocates and prefaults the ring, starts the writer.
+int recorder_open(Recorder* r, const char* path, RecordFormat format,
+                  int sample_rate, int channels);
+
+// Audio thread: copy one rendered block into the ring. Lock- and
+// allocation-free; drops (and counts) the block if the ring is full.
+void recorder_push(Recorder* r, const int16_t* pcm, int n);
+
+// Drains what's left, finalizes the header and prints the stats.
+void recorder_close(Recorder* r);
+
+#endif
@@ -0,0 +1,99 @@
+#include "renderqueue.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "radix.h"
+
+static int grow(RenderQueue* q, int capacity) {
+  RenderPacket* packets = (RenderPacket*)realloc(
+      q->packets, sizeof(RenderPacket) * (size_t)capacity);
+  if (packets) q->packets = packets;
+  uint64_t* keys =
+      (uint64_t*)realloc(q->keys, sizeof(uint64_t) * 2 * (size_t)capacity);
+  if (keys) q->keys = keys;
+  uint32_t* order =
+      (uint32_t*)realloc(q->order, sizeof(uint32_t) * 2 * (size_t)capacity);
+  if (order) q->order = order;
+  // What did grow is only used up to the old capacity
+  if (packets && keys && order) q->capacity = capacity;
+  q->key_tmp = q->keys + q->capacity;
+  q->order_tmp = q->order + q->capacity;
+  return q->capacity == capacity;
+}
+
+int rq_init(RenderQueue* q, int capacity) {
+  memset(q, 0, sizeof(*q));
+  if (grow(q, capacity < 16 ? 16 : capacity)) return 1;
+  rq_free(q);
+  return 0;
+}
+
+void rq_free(RenderQueue* q) {
+  free(q->packets);
+  free(q->keys);
+  free(q->order);
+  memset(q, 0, sizeof(*q));
+}
+
+uint64_t rq_key(RenderPass pass, const RenderPacket* p, float depth) {
+  // A non-negative float's bits sort like the float
+  uint32_t bits = 0;
+  if (depth > 0.0f) memcpy(&bits, &depth, sizeof(bits));
+  return ((uint64_t)pass & 0xF) << 60 | ((uint64_t)p->program & 0xFF) << 52 |
+         ((uint64_t)p->texture & 0x3FF) << 42 |
+         ((uint64_t)p->vao & 0x3FF) << 32 | bits;
+}
+
+int rq_add(RenderQueue* q, RenderPass pass, float depth,
+           const RenderPacket* p) {
+  if (q->count == q->capacity && !grow(q, 2 * q->capacity)) return 0;
+  q->packets[q->count] = *p;
+  q->keys[q->count] = rq_key(pass, p, depth);
+  q->order[q->count] = (uint32_t)q->count;
+  q->count++;
+  return 1;
+}
+
+// State changes issuing `p` after `last` takes, `*texture` being bound
+static int changes(const RenderPacket* last, GLuint* texture,
+                   const RenderPacket* p) {
+  int n = (!last || p->program != last->program) +
+          (!last || p->vao != last->vao);
+  if (p->texture != 0 && p->texture != *texture) {
+    *texture = p->texture;
+    n++;
+  }
+  return n;
+}
+
+void rq_submit(RenderQueue* q) {
+  int unsorted = 0;
+  GLuint texture = 0;
+  for (int i = 0; i < q->count; i++) {
+    unsorted += changes(i > 0 ? &q->packets[i - 1] : NULL, &texture,
+                        &q->packets[i]);
+  }
+  radix_sort(q->keys, q->order, q->count, q->key_tmp, q->order_tmp);
+
+  const RenderPacket* last = NULL;
+  texture = 0;
+  int binds = 0;
+  for (int i = 0; i < q->count; i++) {
+    const RenderPacket* p = &q->packets[q->order[i]];
+    GLuint bound = texture;
+    binds += changes(last, &texture, p);
+    if (!last || p->program != last->program) glUseProgram(p->program);
+    if (texture != bound) {
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, texture);
+    }
+    if (!last || p->vao != last->vao) glBindVertexArray(p->vao);
+    p->draw(p->ctx, p->item);
+    last = p;
+  }
+  q->issued = q->count;
+  q->binds = binds;
+  q->binds_unsorted = unsorted;
+  q->count = 0;
+}
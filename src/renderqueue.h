@@ -0,0 +1,68 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+// --- RENDER QUEUE ---
+// A frame's draws, collected as packets and then issued together in the
+// order of a 64-bit key. From the top bit down the key packs the pass, the
+// program, the texture, the vertex array and the depth: passes run in
+// order, packets that share state end up next to each other, and among
+// those the nearest goes first (so opaque geometry behind what's already
+// drawn fails the depth test before shading). Keys are sorted with a radix
+// sort, which is stable: packets with equal keys (an overlay, say, queued
+// at depth 0) keep the order they were queued in.
+//
+// While issuing, state is only bound when it differs from the previous
+// packet's. The binds that took are counted, along with how many issuing
+// the packets as queued would have taken, to show what the sort saves.
+// Render thread only.
+
+#include <glad/glad.h>
+#include <stdint.h>
+
+typedef enum { RQ_OPAQUE, RQ_OVERLAY } RenderPass;
+
+// Issue one draw; the packet's program, texture and vertex array are bound
+typedef void (*RenderDraw)(void* ctx, int item);
+
+typedef struct {
+  GLuint program;
+  GLuint texture;  // GL_TEXTURE_2D on unit 0; 0 leaves whatever is bound
+  GLuint vao;
+  RenderDraw draw;
+  void* ctx;
+  int item;  // Which part of ctx to draw (a chunk, a vertex count...)
+} RenderPacket;
+
+typedef struct {
+  RenderPacket* packets;
+  uint64_t* keys;
+  uint32_t* order;  // Packet indices, sorted along with the keys
+  uint64_t* key_tmp;
+  uint32_t* order_tmp;
+  int count;
+  int capacity;
+  // The last submit
+  int issued;
+  int binds;           // State changes, sorted
+  int binds_unsorted;  // State changes had it gone in queued order
+} RenderQueue;
+
+// Room for `capacity` packets to start with; the queue grows as needed.
+// Returns 0 if out of memory.
+int rq_init(RenderQueue* q, int capacity);
+void rq_free(RenderQueue* q);
+
+// The sort key. Object names are truncated to the key's fields (8 bits of
+// program, 10 of texture and vertex array), which only costs grouping if
+// they ever collide. `depth` is the distance in front of the camera.
+uint64_t rq_key(RenderPass pass, const RenderPacket* p, float depth);
+
+// Queue a draw. Returns 0 if the queue couldn't grow (the draw is dropped).
+int rq_add(RenderQueue* q, RenderPass pass, float depth,
+           const RenderPacket* p);
+
+// Sort and issue everything queued, then empty the queue. Nothing is
+// assumed about what was bound before: the first packet binds everything.
+void rq_submit(RenderQueue* q);
+
+#endif
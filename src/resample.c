@@ -0,0 +1,131 @@
+#include "resample.h"
+
+#include <math.h>
+#include <string.h>
+
+// Kaiser window shape: ~80 dB stopband with 32 taps
+#define KAISER_BETA 8.0
+// Passband edge as a fraction of the lower Nyquist, leaves room for the
+// transition band
+#define ROLLOFF 0.9
+
+// Zeroth-order modified Bessel function (power series)
+static double bessel_i0(double x) {
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-12) break;
+  }
+  return sum;
+}
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+  while (b) {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+int resampler_init(Resampler* rs, int in_rate, int out_rate) {
+  if (in_rate <= 0 || out_rate <= 0) return 0;
+  memset(rs, 0, sizeof(*rs));
+  uint32_t g = gcd((uint32_t)in_rate, (uint32_t)out_rate);
+  rs->in_step = (uint32_t)in_rate / g;
+  rs->out_step = (uint32_t)out_rate / g;
+  rs->phase_scale = (float)RESAMPLE_PHASES / (float)rs->out_step;
+  rs->quiet = RESAMPLE_TAPS;  // History starts out silent
+
+  // Low-pass at the lower of the two Nyquists so downsampling can't alias
+  double cut = out_rate < in_rate ? (double)out_rate / in_rate : 1.0;
+  cut *= ROLLOFF;
+  const double half = RESAMPLE_TAPS / 2;
+  const double i0_beta = bessel_i0(KAISER_BETA);
+
+  for (int p = 0; p <= RESAMPLE_PHASES; p++) {
+    double sum = 0.0;
+    for (int k = 0; k < RESAMPLE_TAPS; k++) {
+      // Distance from tap k to the interpolation point of this phase
+      double d = (half - 1.0) + (double)p / RESAMPLE_PHASES - k;
+      double x = M_PI * cut * d;
+      double sinc = fabs(x) < 1e-9 ? 1.0 : sin(x) / x;
+      double r = d / half;
+      double win = r * r < 1.0 ? bessel_i0(KAISER_BETA * sqrt(1.0 - r * r)) /
+                                     i0_beta
+                               : 0.0;
+      double h = cut * sinc * win;
+      rs->taps[p][k] = (float)h;
+      sum += h;
+    }
+    // Unity gain at DC for every phase, so there's no phase-dependent ripple
+    for (int k = 0; k < RESAMPLE_TAPS; k++) rs->taps[p][k] /= (float)sum;
+  }
+  return 1;
+}
+
+int resampler_input_frames(const Resampler* rs, int out_n) {
+  uint64_t end = rs->frac + (uint64_t)out_n * rs->in_step;
+  return (int)(end / rs->out_step);
+}
+
+int resampler_output_frames(const Resampler* rs, int in_max) {
+  if (in_max > RESAMPLE_MAX_IN) in_max = RESAMPLE_MAX_IN;
+  // Largest out_n with frac + out_n * in_step < (in_max + 1) * out_step
+  uint64_t limit = (uint64_t)(in_max + 1) * rs->out_step - 1 - rs->frac;
+  return (int)(limit / rs->in_step);
+}
+
+int resampler_latency(const Resampler* rs) {
+  (void)rs;
+  return RESAMPLE_TAPS / 2 + 1;
+}
+
+bool resampler_process(Resampler* rs, const float* in, int in_n, float* out,
+                       int out_n, bool silent) {
+  uint64_t end = rs->frac + (uint64_t)out_n * rs->in_step;
+
+  if (silent && rs->quiet >= RESAMPLE_TAPS) {
+    // Zeros in and zeros in the history: the history stays all-zero too
+    memset(out, 0, sizeof(float) * (size_t)out_n);
+    rs->frac = (uint32_t)(end % rs->out_step);
+    rs->quiet += in_n;
+    return false;
+  }
+  rs->quiet = silent ? rs->quiet + in_n : 0;
+
+  float* hist = rs->hist;
+  memcpy(hist + RESAMPLE_TAPS, in, sizeof(float) * (size_t)in_n);
+
+  uint64_t pos = rs->frac;
+  for (int j = 0; j < out_n; j++) {
+    const float* x = hist + pos / rs->out_step;
+    float ph = (float)(uint32_t)(pos % rs->out_step) * rs->phase_scale;
+    int p = (int)ph;
+    float w = ph - (float)p;
+    const float* restrict h0 = rs->taps[p];
+    const float* restrict h1 = rs->taps[p + 1];
+
+    // Two dot products with eight-lane accumulators: vectorises cleanly
+    float a[8] = {0}, b[8] = {0};
+    for (int k = 0; k < RESAMPLE_TAPS; k += 8) {
+      for (int l = 0; l < 8; l++) {
+        a[l] += h0[k + l] * x[k + l];
+        b[l] += h1[k + l] * x[k + l];
+      }
+    }
+    float sa = 0.0f, sb = 0.0f;
+    for (int l = 0; l < 8; l++) {
+      sa += a[l];
+      sb += b[l];
+    }
+    out[j] = sa + w * (sb - sa);
+    pos += rs->in_step;
+  }
+  rs->frac = (uint32_t)(end % rs->out_step);
+
+  // Keep the newest RESAMPLE_TAPS samples as history
+  memmove(hist, hist + in_n, sizeof(float) * RESAMPLE_TAPS);
+  return true;
+}
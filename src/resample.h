@@ -0,0 +1,55 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+// --- POLYPHASE SAMPLE-RATE CONVERTER ---
+// Bridges the engine rate and the device rate when they differ (a low
+// internal rate on weak hardware, or a device that only runs at 48 kHz).
+// A Kaiser-windowed sinc is tabulated as RESAMPLE_PHASES sub-sample phases
+// of RESAMPLE_TAPS taps each; every output sample is a blend of the two
+// nearest phases, computed as two dot products that vectorise. The read
+// position advances in exact integer steps of in_rate / out_rate, so the
+// number of input frames each output block needs is known in advance and
+// nothing drifts over a long show.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RESAMPLE_TAPS 32     // Filter length (16 zero crossings a side)
+#define RESAMPLE_PHASES 256  // Tabulated sub-sample positions
+#define RESAMPLE_MAX_IN 4096  // Largest input block per call
+
+typedef struct {
+  // Reduced rate ratio: each output advances the input by in_step / out_step
+  uint32_t in_step;
+  uint32_t out_step;
+  uint32_t frac;  // Sub-sample position, 0..out_step-1
+  float phase_scale;  // RESAMPLE_PHASES / out_step
+
+  // Phase p, tap k; one extra row so phase + 1 is always valid
+  float taps[RESAMPLE_PHASES + 1][RESAMPLE_TAPS];
+
+  // Last RESAMPLE_TAPS input samples followed by the current block
+  float hist[RESAMPLE_TAPS + RESAMPLE_MAX_IN];
+  long long quiet;  // Consecutive silent input samples
+} Resampler;
+
+// Returns 0 if either rate is not a positive integer.
+int resampler_init(Resampler* rs, int in_rate, int out_rate);
+
+// Input frames the next out_n output frames will consume (may be 0).
+int resampler_input_frames(const Resampler* rs, int out_n);
+
+// Most output frames that can be produced from at most in_max input frames.
+int resampler_output_frames(const Resampler* rs, int in_max);
+
+// Convert exactly resampler_input_frames(rs, out_n) input frames into out_n
+// output frames. `silent` says the input is all zeros; once the filter
+// history is silent too the output is a memset. Returns false when the
+// output is silent.
+bool resampler_process(Resampler* rs, const float* in, int in_n, float* out,
+                       int out_n, bool silent);
+
+// Group delay in input samples (for latency reporting).
+int resampler_latency(const Resampler* rs);
+
+#endif
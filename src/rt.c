@@ -0,0 +1,223 @@
+#include "rt.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef HAVE_RTKIT
+#include <dbus/dbus.h>
+#endif
+
+// The allocation/lock guard relies on glibc's __libc_* entry points to
+// interpose malloc without recursion, so it only exists in Linux debug builds.
+#if defined(__GLIBC__) && !defined(NDEBUG)
+#define RT_HAVE_GUARD 1
+#include <dlfcn.h>
+#endif
+
+static atomic_bool g_guard_enabled;
+static _Thread_local bool tls_in_dsp;
+
+void rt_init(RtReport* r) {
+  memset(r, 0, sizeof(*r));
+  r->scheduler = "none";
+  atomic_init(&r->thread_ready, false);
+}
+
+void rt_lock_memory(RtReport* r) {
+#ifdef MCL_CURRENT
+  r->memory_locked = mlockall(MCL_CURRENT) == 0;
+  r->mlock_errno = r->memory_locked ? 0 : errno;
+#else
+  r->mlock_errno = ENOSYS;
+#endif
+}
+
+bool rt_prefault(void* p, size_t len) {
+  // Write every page so copy-on-write / zero pages are materialised, then
+  // lock them so they can't be evicted again.
+  long page = sysconf(_SC_PAGESIZE);
+  volatile char* c = (volatile char*)p;
+  for (size_t off = 0; off < len; off += (size_t)page) c[off] = c[off];
+  return mlock(p, len) == 0;
+}
+
+// Touch a chunk of our own stack now so the callback never grows into an
+// unmapped guard page mid-block. The pages stay locked after we return.
+static bool prefault_stack(void) {
+  char stack[RT_STACK_PREFAULT_BYTES];
+  memset(stack, 0, sizeof(stack));
+  bool ok = mlock(stack, sizeof(stack)) == 0;
+  __asm__ volatile("" : : "r"(stack) : "memory");  // Keep the memset
+  return ok;
+}
+
+#ifdef HAVE_RTKIT
+// Ask rtkit (org.freedesktop.RealtimeKit1) to promote a thread. This is how
+// desktop Linux hands out SCHED_FIFO to unprivileged users.
+static bool rtkit_make_realtime(pid_t tid, int prio) {
+  // rtkit refuses clients that could hog the CPU forever
+  struct rlimit rl = {200000, 200000};  // 200 ms of RT CPU without a sleep
+  setrlimit(RLIMIT_RTTIME, &rl);
+
+  DBusError err;
+  dbus_error_init(&err);
+  DBusConnection* bus = dbus_bus_get_private(DBUS_BUS_SYSTEM, &err);
+  if (!bus) {
+    dbus_error_free(&err);
+    return false;
+  }
+  dbus_connection_set_exit_on_disconnect(bus, FALSE);
+
+  DBusMessage* m = dbus_message_new_method_call(
+      "org.freedesktop.RealtimeKit1", "/org/freedesktop/RealtimeKit1",
+      "org.freedesktop.RealtimeKit1", "MakeThreadRealtime");
+  dbus_uint64_t t = (dbus_uint64_t)tid;
+  dbus_uint32_t p = (dbus_uint32_t)prio;
+  bool ok = false;
+  if (m && dbus_message_append_args(m, DBUS_TYPE_UINT64, &t, DBUS_TYPE_UINT32,
+                                    &p, DBUS_TYPE_INVALID)) {
+    DBusMessage* reply =
+        dbus_connection_send_with_reply_and_block(bus, m, 1000, &err);
+    ok = reply != NULL;
+    if (reply) dbus_message_unref(reply);
+  }
+  if (m) dbus_message_unref(m);
+  dbus_error_free(&err);
+  dbus_connection_close(bus);
+  dbus_connection_unref(bus);
+  return ok;
+}
+#endif
+
+void rt_audio_thread_enter(RtReport* r, bool os_managed) {
+  if (os_managed) {
+    // CoreAudio already runs AQCallback on a time-constraint thread
+    r->scheduler = "CoreAudio";
+  } else {
+    struct sched_param sp = {0};
+    int max = sched_get_priority_max(SCHED_FIFO);
+    sp.sched_priority = RT_AUDIO_PRIORITY < max ? RT_AUDIO_PRIORITY : max;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    if (rc == 0) {
+      r->scheduler = "SCHED_FIFO";
+      r->priority = sp.sched_priority;
+    } else {
+      r->sched_errno = rc;
+#ifdef HAVE_RTKIT
+      if (rtkit_make_realtime((pid_t)syscall(SYS_gettid), sp.sched_priority)) {
+        r->scheduler = "rtkit";
+        r->priority = sp.sched_priority;
+      }
+#endif
+    }
+  }
+
+  r->stack_prefaulted = prefault_stack();
+
+#ifdef RT_HAVE_GUARD
+  atomic_store(&g_guard_enabled, true);
+  r->guard_armed = true;
+#endif
+  atomic_store_explicit(&r->thread_ready, true, memory_order_release);
+}
+
+void rt_print_report(RtReport* r, double timeout_sec) {
+  const struct timespec nap = {0, 1000 * 1000};
+  for (double waited = 0.0; waited < timeout_sec; waited += 0.001) {
+    if (atomic_load_explicit(&r->thread_ready, memory_order_acquire)) break;
+    nanosleep(&nap, NULL);
+  }
+  bool ready = atomic_load_explicit(&r->thread_ready, memory_order_acquire);
+
+  printf("Real-time mode:\n");
+  if (r->memory_locked)
+    printf("  memory locked (mlockall): yes\n");
+  else
+    printf("  memory locked (mlockall): no (%s)\n", strerror(r->mlock_errno));
+  printf("  DSP buffers prefaulted:   %s\n",
+         r->buffers_prefaulted ? "yes" : "no");
+  if (!ready) {
+    printf("  audio thread:             never ran, nothing else granted\n");
+    return;
+  }
+  printf("  audio stack prefaulted:   %s (%d KB)\n",
+         r->stack_prefaulted ? "yes" : "no", RT_STACK_PREFAULT_BYTES / 1024);
+  if (r->priority > 0)
+    printf("  scheduling:               %s priority %d\n", r->scheduler,
+           r->priority);
+  else if (strcmp(r->scheduler, "none") == 0)
+    printf("  scheduling:               none (%s)\n", strerror(r->sched_errno));
+  else
+    printf("  scheduling:               %s\n", r->scheduler);
+  printf("  alloc/lock guard:         %s\n",
+         r->guard_armed ? "armed" : "not built (release or non-glibc)");
+}
+
+void rt_guard_enter(void) { tls_in_dsp = true; }
+void rt_guard_leave(void) { tls_in_dsp = false; }
+
+#ifdef RT_HAVE_GUARD
+// --- DEBUG GUARD ---
+// These definitions interpose libc's for the whole process. Outside the DSP
+// section (or before real-time mode is armed) they just forward.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* p, size_t size);
+extern void __libc_free(void* p);
+
+static void rt_trap(const char* what) {
+  // No printf here: it may allocate, which is the thing we're trapping
+  static const char msg[] = "RT GUARD: audio thread called ";
+  write(STDERR_FILENO, msg, sizeof(msg) - 1);
+  write(STDERR_FILENO, what, strlen(what));
+  write(STDERR_FILENO, "\n", 1);
+  abort();
+}
+
+static inline void rt_check(const char* what) {
+  if (tls_in_dsp &&
+      atomic_load_explicit(&g_guard_enabled, memory_order_relaxed))
+    rt_trap(what);
+}
+
+void* malloc(size_t size) {
+  rt_check("malloc");
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+  rt_check("calloc");
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size) {
+  rt_check("realloc");
+  return __libc_realloc(p, size);
+}
+
+void free(void* p) {
+  rt_check("free");
+  __libc_free(p);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* m) {
+  static int (*real_lock)(pthread_mutex_t*);
+  rt_check("pthread_mutex_lock");
+  if (!real_lock)
+    real_lock = (int (*)(pthread_mutex_t*))dlsym(RTLD_NEXT,
+                                                  "pthread_mutex_lock");
+  return real_lock(m);
+}
+#endif
@@ -0,0 +1,53 @@
+#ifndef RT_H
+#define RT_H
+
+// --- REAL-TIME HARDENING FOR THE AUDIO THREAD ---
+// CoreAudio hands AQCallback a time-constraint thread for free; elsewhere we
+// have to ask for it. This opt-in mode raises the audio thread to SCHED_FIFO
+// (or asks rtkit to), pins the process's memory with mlockall, prefaults the
+// audio stack and DSP buffers, and in debug builds arms a guard that aborts
+// on any malloc/free or mutex lock made from inside the DSP section.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Priority requested for the audio thread. rtkit caps clients at 20 by
+// default, so asking for more would just fail there.
+#define RT_AUDIO_PRIORITY 20
+#define RT_STACK_PREFAULT_BYTES (64 * 1024)
+
+// What we asked for and what the OS actually granted.
+typedef struct {
+  bool memory_locked;
+  int mlock_errno;
+  bool buffers_prefaulted;
+  bool stack_prefaulted;
+  const char* scheduler;  // "SCHED_FIFO", "rtkit", "CoreAudio" or "none"
+  int priority;
+  int sched_errno;
+  bool guard_armed;
+  atomic_bool thread_ready;  // Set once the audio thread has hardened itself
+} RtReport;
+
+void rt_init(RtReport* r);
+
+// Lock every page mapped so far (MCL_CURRENT only, so the sampler's mmap'd
+// WAVs stay pageable and are handled by its prefetch thread instead).
+void rt_lock_memory(RtReport* r);
+
+// Touch and mlock a buffer the audio thread will use.
+bool rt_prefault(void* p, size_t len);
+
+// Call from the audio thread itself, before its first block.
+void rt_audio_thread_enter(RtReport* r, bool os_managed);
+
+// Wait (up to timeout_sec) for the audio thread, then print what we got.
+void rt_print_report(RtReport* r, double timeout_sec);
+
+// Brackets the DSP section of the callback. While inside, the debug guard
+// traps any allocation or lock taken by this thread. No-ops in release.
+void rt_guard_enter(void);
+void rt_guard_leave(void);
+
+#endif
@@ -0,0 +1,256 @@
+#include "sampler.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// WAV headers are little-endian; read them byte by byte so we never do an
+// unaligned load straight out of the mapping.
+static uint32_t rd_le32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static uint16_t rd_le16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void sampler_init(Sampler* s, double out_rate) {
+  memset(s, 0, sizeof(*s));
+  s->out_rate = out_rate;
+  s->page_size = (size_t)sysconf(_SC_PAGESIZE);
+  atomic_init(&s->num_samples, 0);
+  atomic_init(&s->running, false);
+  for (int i = 0; i < SAMPLER_MAX_VOICES; i++) {
+    atomic_init(&s->voices[i].sample, -1);
+    atomic_init(&s->voices[i].cursor, 0);
+  }
+}
+
+// Walk the RIFF chunk list and fill in the format / data fields.
+static int parse_wav(Sample* smp) {
+  const uint8_t* p = smp->map;
+  size_t len = smp->map_len;
+  if (len < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0)
+    return 0;
+
+  int have_fmt = 0;
+  size_t off = 12;
+  while (off + 8 <= len) {
+    const uint8_t* chunk = p + off;
+    size_t size = rd_le32(chunk + 4);
+    const uint8_t* body = chunk + 8;
+
+    if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && off + 8 + 16 <= len) {
+      int tag = rd_le16(body);
+      // WAVE_FORMAT_EXTENSIBLE keeps the real tag at the start of the GUID
+      if (tag == 0xFFFE && size >= 40 && off + 8 + 40 <= len)
+        tag = rd_le16(body + 24);
+      smp->channels = rd_le16(body + 2);
+      smp->sample_rate = (double)rd_le32(body + 4);
+      int bits = rd_le16(body + 14);
+
+      if (tag == 1 && bits == 16)
+        smp->format = SAMPLE_FMT_S16;
+      else if (tag == 3 && bits == 32)
+        smp->format = SAMPLE_FMT_F32;
+      else
+        return 0;
+      if (smp->channels < 1 || smp->channels > 2 || smp->sample_rate <= 0)
+        return 0;
+      smp->bytes_per_frame = smp->channels * (bits / 8);
+      have_fmt = 1;
+    } else if (memcmp(chunk, "data", 4) == 0 && have_fmt) {
+      // Truncated files are common; clamp to what is actually mapped
+      if (size > len - off - 8) size = len - off - 8;
+      smp->pcm = body;
+      smp->frames = size / (size_t)smp->bytes_per_frame;
+      return smp->frames > 1;
+    }
+    // Chunks are padded to an even size
+    off += 8 + size + (size & 1);
+  }
+  return 0;
+}
+
+int sampler_load(Sampler* s, const char* path, bool loop) {
+  int id = atomic_load(&s->num_samples);
+  if (id >= SAMPLER_MAX_SAMPLES) return -1;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return -1;
+  }
+
+  // Read-only private mapping: the kernel pages PCM in from the page cache on
+  // demand and can drop it again under pressure without touching swap.
+  void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping keeps the file alive
+  if (map == MAP_FAILED) return -1;
+
+  Sample* smp = &s->samples[id];
+  memset(smp, 0, sizeof(*smp));
+  smp->map = (const uint8_t*)map;
+  smp->map_len = (size_t)st.st_size;
+  smp->loop = loop;
+
+  if (!parse_wav(smp)) {
+    munmap(map, smp->map_len);
+    return -1;
+  }
+
+  // Ask for read-ahead of the head so the first trigger hits resident pages
+  size_t head = smp->frames * (size_t)smp->bytes_per_frame;
+  if (head > SAMPLER_PREFETCH_BYTES) head = SAMPLER_PREFETCH_BYTES;
+  size_t skew = (size_t)(smp->pcm - smp->map) % s->page_size;
+  madvise((void*)(smp->pcm - skew), head + skew, MADV_WILLNEED);
+
+  // Publish only after the Sample is completely filled in
+  atomic_store_explicit(&s->num_samples, id + 1, memory_order_release);
+  return id;
+}
+
+// Read one byte per page so every page in [from, from + len) is resident.
+static void touch_pages(const Sampler* s, const Sample* smp, size_t from,
+                        size_t len) {
+  size_t total = smp->frames * (size_t)smp->bytes_per_frame;
+  if (from >= total) return;
+  if (len > total - from) len = total - from;
+
+  const volatile uint8_t* p = smp->pcm + from;
+  uint8_t sink = 0;
+  for (size_t off = 0; off < len; off += s->page_size) sink ^= p[off];
+  sink ^= p[len - 1];
+  (void)sink;
+}
+
+// --- PREFETCH THREAD ---
+// Runs every couple of milliseconds, far more often than one callback drains
+// the window, and keeps both the play-ahead region of each voice and the
+// head of every sample warm (so a fresh trigger never starts cold).
+static void* prefetch_main(void* arg) {
+  Sampler* s = (Sampler*)arg;
+  const struct timespec nap = {0, 2 * 1000 * 1000};
+
+  while (atomic_load_explicit(&s->running, memory_order_acquire)) {
+    int n = atomic_load_explicit(&s->num_samples, memory_order_acquire);
+
+    for (int v = 0; v < SAMPLER_MAX_VOICES; v++) {
+      int id = atomic_load_explicit(&s->voices[v].sample,
+                                    memory_order_acquire);
+      if (id < 0 || id >= n) continue;
+      const Sample* smp = &s->samples[id];
+      size_t cur = atomic_load_explicit(&s->voices[v].cursor,
+                                        memory_order_relaxed);
+      touch_pages(s, smp, cur * (size_t)smp->bytes_per_frame,
+                  SAMPLER_PREFETCH_BYTES);
+    }
+
+    for (int i = 0; i < n; i++)
+      touch_pages(s, &s->samples[i], 0, SAMPLER_PREFETCH_BYTES);
+
+    nanosleep(&nap, NULL);
+  }
+  return NULL;
+}
+
+int sampler_start_prefetch(Sampler* s) {
+  atomic_store(&s->running, true);
+  if (pthread_create(&s->prefetch_thread, NULL, prefetch_main, s) != 0) {
+    atomic_store(&s->running, false);
+    return 0;
+  }
+  return 1;
+}
+
+void sampler_shutdown(Sampler* s) {
+  if (atomic_exchange(&s->running, false))
+    pthread_join(s->prefetch_thread, NULL);
+
+  int n = atomic_load(&s->num_samples);
+  for (int i = 0; i < n; i++)
+    munmap((void*)s->samples[i].map, s->samples[i].map_len);
+  atomic_store(&s->num_samples, 0);
+}
+
+void sampler_trigger(Sampler* s, int id, double rate, double vol) {
+  if (id < 0 || id >= atomic_load(&s->num_samples)) return;
+
+  // Prefer an idle voice, otherwise steal the one triggered longest ago
+  SamplerVoice* v = &s->voices[0];
+  for (int i = 0; i < SAMPLER_MAX_VOICES; i++) {
+    SamplerVoice* c = &s->voices[i];
+    if (atomic_load_explicit(&c->sample, memory_order_relaxed) < 0) {
+      v = c;
+      break;
+    }
+    if (c->age < v->age) v = c;
+  }
+
+  const Sample* smp = &s->samples[id];
+  v->pos = 0.0;
+  v->step = rate * smp->sample_rate / s->out_rate;
+  v->vol = vol;
+  v->age = ++s->trigger_count;
+  atomic_store_explicit(&v->cursor, 0, memory_order_relaxed);
+  atomic_store_explicit(&v->sample, id, memory_order_release);
+}
+
+// Mono frame at index i (stereo is averaged down to the engine's mono bus).
+static inline double sample_frame(const Sample* smp, size_t i) {
+  const uint8_t* f = smp->pcm + i * (size_t)smp->bytes_per_frame;
+  if (smp->format == SAMPLE_FMT_S16) {
+    int16_t l, r;
+    memcpy(&l, f, 2);
+    if (smp->channels == 1) return l / 32768.0;
+    memcpy(&r, f + 2, 2);
+    return (l + r) / 65536.0;
+  }
+  float l, r;
+  memcpy(&l, f, 4);
+  if (smp->channels == 1) return l;
+  memcpy(&r, f + 4, 4);
+  return 0.5 * ((double)l + r);
+}
+
+bool sampler_mix(Sampler* s, float* bus, int n) {
+  bool mixed = false;
+  for (int v = 0; v < SAMPLER_MAX_VOICES; v++) {
+    SamplerVoice* voice = &s->voices[v];
+    int id = atomic_load_explicit(&voice->sample, memory_order_acquire);
+    if (id < 0) continue;
+    mixed = true;
+    const Sample* smp = &s->samples[id];
+    double last = (double)(smp->frames - 1);
+
+    for (int i = 0; i < n; i++) {
+      if (voice->pos >= last) {
+        if (!smp->loop) {
+          atomic_store_explicit(&voice->sample, -1, memory_order_release);
+          break;
+        }
+        voice->pos -= last;
+      }
+
+      // Linear interpolation between neighbouring frames for repitching
+      size_t idx = (size_t)voice->pos;
+      double frac = voice->pos - (double)idx;
+      double a = sample_frame(smp, idx);
+      double b = sample_frame(smp, idx + 1);
+      bus[i] += (float)((a + (b - a) * frac) * voice->vol);
+      voice->pos += voice->step;
+    }
+
+    // Tell the prefetch thread where we'll be reading from next
+    atomic_store_explicit(&voice->cursor, (size_t)voice->pos,
+                          memory_order_relaxed);
+  }
+  return mixed;
+}
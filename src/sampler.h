@@ -0,0 +1,79 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+// --- MEMORY-MAPPED SAMPLE PLAYBACK ---
+// WAV files are mmap'd instead of being read into the heap, so the page cache
+// holds the PCM and we can ship gigabytes of one-shots and loops without
+// paying for them at startup. A prefetch thread walks ahead of every play
+// cursor and touches the pages the audio thread is about to read, so the
+// audio callback itself never takes a page fault.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SAMPLER_MAX_SAMPLES 64
+#define SAMPLER_MAX_VOICES 16
+
+// How far ahead of the play cursor the prefetch thread keeps pages resident.
+// 256 KB is ~1.5 s of 16-bit stereo at 44.1 kHz, far more than one callback.
+#define SAMPLER_PREFETCH_BYTES (256 * 1024)
+
+enum { SAMPLE_FMT_S16 = 1, SAMPLE_FMT_F32 = 3 };
+
+// One mapped WAV file. Immutable once sampler_load() returns.
+typedef struct {
+  const uint8_t* map;  // Whole file mapping (for munmap)
+  size_t map_len;
+  const uint8_t* pcm;  // Start of the "data" chunk inside the mapping
+  size_t frames;
+  int channels;  // 1 or 2, stereo is folded to mono on playback
+  int format;    // SAMPLE_FMT_S16 or SAMPLE_FMT_F32
+  int bytes_per_frame;
+  double sample_rate;
+  bool loop;
+} Sample;
+
+// A playing instance of a Sample. The audio thread owns pos/step/vol; the
+// prefetch thread only ever looks at the two atomics.
+typedef struct {
+  _Atomic int sample;     // Index into Sampler.samples, -1 when idle
+  _Atomic size_t cursor;  // Frame the audio thread will read next
+  double pos;             // Fractional read position in frames
+  double step;            // Source frames per output sample
+  double vol;
+  unsigned age;  // Trigger order, used to steal the oldest voice
+} SamplerVoice;
+
+typedef struct {
+  Sample samples[SAMPLER_MAX_SAMPLES];
+  _Atomic int num_samples;
+  SamplerVoice voices[SAMPLER_MAX_VOICES];
+  unsigned trigger_count;
+  double out_rate;
+
+  pthread_t prefetch_thread;
+  atomic_bool running;
+  size_t page_size;
+} Sampler;
+
+void sampler_init(Sampler* s, double out_rate);
+
+// Maps a 16-bit PCM or 32-bit float WAV (mono or stereo). Returns the sample
+// id, or -1 if the file could not be mapped or is not a supported WAV.
+int sampler_load(Sampler* s, const char* path, bool loop);
+
+// Starts / stops the background thread that keeps upcoming pages resident.
+int sampler_start_prefetch(Sampler* s);
+void sampler_shutdown(Sampler* s);
+
+// Starts sample `id` at `rate` (1.0 = original pitch). Audio thread only.
+void sampler_trigger(Sampler* s, int id, double rate, double vol);
+
+// Adds every active voice into the float master bus. Audio thread only.
+// Returns false if no voice was playing (bus untouched).
+bool sampler_mix(Sampler* s, float* bus, int n);
+
+#endif
@@ -0,0 +1,43 @@
+#include "schedule.h"
+
+void sched_init(SchedQueue* q) {
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+}
+
+int sched_push(SchedQueue* q, long long time, int kind, int id, float a,
+               float b) {
+  unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  if (head - tail >= SCHED_CAP) return 0;
+
+  SchedEvent* e = &q->events[head & (SCHED_CAP - 1)];
+  e->time = time;
+  e->kind = kind;
+  e->id = id;
+  e->a = a;
+  e->b = b;
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+  return 1;
+}
+
+int sched_until(SchedQueue* q, long long pos, int n) {
+  unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+  if (tail == head) return n;
+  long long due = q->events[tail & (SCHED_CAP - 1)].time - pos;
+  // A due (or overdue) event is popped at the block start
+  if (due <= 0 || due >= n) return n;
+  return (int)due;
+}
+
+bool sched_pop_due(SchedQueue* q, long long pos, SchedEvent* out) {
+  unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+  if (tail == head) return false;
+  const SchedEvent* e = &q->events[tail & (SCHED_CAP - 1)];
+  if (e->time > pos) return false;
+  *out = *e;
+  atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+  return true;
+}
@@ -0,0 +1,45 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+// --- SAMPLE-ACCURATE NOTE SCHEDULE ---
+// The render loop knows where the next beats fall (on the network timeline)
+// well before the audio thread gets there, but only to within a frame.
+// Instead of firing notes when a frame notices a beat, it queues them here
+// stamped with the engine sample they should sound on. The audio thread
+// splits its blocks at each event's sample, like automation lane events in
+// params.h, so a beat lands on its exact sample whatever the frame timing.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define SCHED_CAP 1024  // Pending events (power of two)
+
+typedef struct {
+  long long time;  // Engine sample clock; anything in the past plays at once
+  int kind;        // The app's own event enum
+  int id;
+  float a, b;
+} SchedEvent;
+
+typedef struct {
+  SchedEvent events[SCHED_CAP];
+  _Atomic unsigned head;  // Next slot the producer writes
+  _Atomic unsigned tail;  // Next event the audio thread plays
+} SchedQueue;
+
+void sched_init(SchedQueue* q);
+
+// --- PRODUCER (one thread) ---
+// Events must be pushed in time order. Returns 0 if the queue is full.
+int sched_push(SchedQueue* q, long long time, int kind, int id, float a,
+               float b);
+
+// --- AUDIO THREAD ---
+// How many of the next n samples from `pos` can be rendered before an
+// event is due (the caller splits its block there).
+int sched_until(SchedQueue* q, long long pos, int n);
+
+// Pop the next event due at or before `pos`. Returns false when none is.
+bool sched_pop_due(SchedQueue* q, long long pos, SchedEvent* out);
+
+#endif
@@ -0,0 +1,168 @@
+#include "stream.h"
+
+#include <string.h>
+#include <time.h>
+
+// GL 4.4 / ARB_buffer_storage, beyond the 3.3 core loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void(APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size,
+                                          const void* data, GLbitfield flags);
+static BufferStorageProc g_buffer_storage;
+
+#define STREAM_GRANULE (1 << 20)  // Regions grow in whole megabytes
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool has_buffer_storage(void) {
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (major > 4 || (major == 4 && minor >= 4)) return true;
+  GLint n = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+  for (GLint i = 0; i < n; i++) {
+    const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+    if (ext && strcmp(ext, "GL_ARB_buffer_storage") == 0) return true;
+  }
+  return false;
+}
+
+int stream_init(StreamBuffer* s, bool persistent, GLADloadproc load) {
+  memset(s, 0, sizeof(*s));
+  if (persistent && has_buffer_storage()) {
+    g_buffer_storage = (BufferStorageProc)load("glBufferStorage");
+    s->persistent = g_buffer_storage != NULL;
+  }
+  return 1;
+}
+
+// Drop the GL buffer and fences once the GPU is done with all of them
+static void release(StreamBuffer* s) {
+  stream_unmap(s);
+  if (s->buffer) glFinish();
+  for (int f = 0; f < STREAM_FRAMES; f++) {
+    if (s->fences[f]) glDeleteSync(s->fences[f]);
+    s->fences[f] = NULL;
+  }
+  if (s->base) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, s->buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    s->base = NULL;
+  }
+  if (s->buffer) glDeleteBuffers(1, &s->buffer);
+  s->buffer = 0;
+  s->region = 0;
+  s->head = 0;
+}
+
+int stream_reserve(StreamBuffer* s, size_t region) {
+  if (region <= s->region) return 1;
+  release(s);
+  // Start from a clean error state, so the checks below see only ours
+  while (glGetError() != GL_NO_ERROR) continue;
+  region = (region + STREAM_GRANULE - 1) / STREAM_GRANULE * STREAM_GRANULE;
+  GLsizeiptr total = (GLsizeiptr)(region * STREAM_FRAMES);
+
+  glGenBuffers(1, &s->buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, s->buffer);
+  if (s->persistent) {
+    // Immutable storage, mapped for good: writes land in place and are
+    // seen by any command issued after them
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    g_buffer_storage(GL_COPY_WRITE_BUFFER, total, NULL, flags);
+    if (glGetError() == GL_NO_ERROR) {
+      s->base = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0,
+                                                 total, flags);
+    }
+  } else {
+    glBufferData(GL_COPY_WRITE_BUFFER, total, NULL, GL_STREAM_DRAW);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  if (glGetError() != GL_NO_ERROR || (s->persistent && !s->base)) {
+    release(s);
+    return 0;
+  }
+  s->region = region;
+  s->frame = 0;
+  return 1;
+}
+
+void stream_begin_frame(StreamBuffer* s) {
+  stream_unmap(s);
+  s->frame = (s->frame + 1) % STREAM_FRAMES;
+  s->head = 0;
+  s->bytes = 0;
+  s->stall = 0.0;
+  GLsync fence = s->fences[s->frame];
+  if (!fence) return;
+  s->fences[s->frame] = NULL;
+
+  // Normally signalled frames ago. If not, the GPU is more than
+  // STREAM_FRAMES behind and this is the time it costs us.
+  GLenum r = glClientWaitSync(fence, 0, 0);
+  if (r == GL_TIMEOUT_EXPIRED) {
+    double start = now_sec();
+    do {
+      r = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    } while (r == GL_TIMEOUT_EXPIRED);
+    s->stall = now_sec() - start;
+  }
+  glDeleteSync(fence);
+}
+
+void* stream_map(StreamBuffer* s, size_t bytes, size_t align,
+                 size_t* offset) {
+  size_t at = (s->head + align - 1) & ~(align - 1);
+  if (bytes == 0 || at + bytes > s->region) return NULL;
+  stream_unmap(s);
+  size_t off = (size_t)s->frame * s->region + at;
+  void* p;
+  if (s->persistent) {
+    p = s->base + off;
+  } else {
+    // The fence already guarantees the GPU is done with this range, so
+    // the driver needn't check
+    glBindBuffer(GL_COPY_WRITE_BUFFER, s->buffer);
+    p = glMapBufferRange(GL_COPY_WRITE_BUFFER, (GLintptr)off,
+                         (GLsizeiptr)bytes,
+                         GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                             GL_MAP_INVALIDATE_RANGE_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (!p) return NULL;
+    s->mapped = true;
+  }
+  s->head = at + bytes;
+  s->bytes += bytes;
+  *offset = off;
+  return p;
+}
+
+void stream_unmap(StreamBuffer* s) {
+  if (!s->mapped) return;
+  glBindBuffer(GL_COPY_WRITE_BUFFER, s->buffer);
+  glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  s->mapped = false;
+}
+
+void stream_end_frame(StreamBuffer* s) {
+  stream_unmap(s);
+  if (!s->buffer) return;
+  s->fences[s->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void stream_free(StreamBuffer* s) {
+  release(s);
+  memset(s, 0, sizeof(*s));
+}
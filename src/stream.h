@@ -0,0 +1,67 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+// --- STREAMING UPLOADS ---
+// One big GL buffer used as a ring for data rewritten every frame (the
+// per-frame uniform block, instance matrices, visible lists). The ring is
+// split into STREAM_FRAMES regions, one per frame in flight. A frame only
+// writes its own region, so the GPU can still be reading the previous
+// frames' regions without the driver stepping in to synchronise. A fence
+// per region marks when the GPU is done with it, and the CPU waits on that
+// fence (normally already signalled) before reusing the region.
+//
+// With GL 4.4 or ARB_buffer_storage the whole ring is mapped once,
+// persistently and coherently, and writes go straight in. Otherwise each
+// allocation is mapped with GL_MAP_UNSYNCHRONIZED_BIT, which is safe for
+// the same reason: the fence already says the range is free.
+//
+// Render thread only. Maps through GL_COPY_WRITE_BUFFER, so the vertex and
+// uniform bindings are left alone.
+
+#include <glad/glad.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define STREAM_FRAMES 3
+
+typedef struct {
+  unsigned int buffer;
+  size_t region;  // Bytes per frame
+  bool persistent;
+  unsigned char* base;  // The whole ring, when persistent
+  bool mapped;          // An unsynchronized range is mapped
+  GLsync fences[STREAM_FRAMES];
+  int frame;    // Current region
+  size_t head;  // Bytes used in it
+
+  // This frame so far
+  size_t bytes;  // Handed out by stream_map
+  double stall;  // Seconds spent waiting for the GPU in stream_begin_frame
+} StreamBuffer;
+
+// Set up an empty ring. Persistent mapping is used if `persistent` and the
+// context supports it (glBufferStorage is fetched through `load`). Returns
+// 0 if the GL buffer couldn't be created.
+int stream_init(StreamBuffer* s, bool persistent, GLADloadproc load);
+
+// Make every region at least `region` bytes. Reallocating waits for the GPU
+// to finish, so size for the worst case rather than per frame. Returns 0
+// (leaving the ring empty) if the buffer couldn't be allocated.
+int stream_reserve(StreamBuffer* s, size_t region);
+
+// Move to the next region, waiting until the GPU has finished with it.
+void stream_begin_frame(StreamBuffer* s);
+
+// `bytes` of this frame's region, aligned to `align` (a power of two).
+// Returns where to write, and the buffer offset for binding in *offset, or
+// NULL if the region is full. Call stream_unmap before drawing from it.
+void* stream_map(StreamBuffer* s, size_t bytes, size_t align,
+                 size_t* offset);
+void stream_unmap(StreamBuffer* s);
+
+// Fence the region once the frame's draws have been issued.
+void stream_end_frame(StreamBuffer* s);
+
+void stream_free(StreamBuffer* s);
+
+#endif
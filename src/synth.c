@@ -0,0 +1,140 @@
+#include "synth.h"
+
+#include <math.h>
+#include <string.h>
+
+void synth_init(AudioState* as, double sample_rate) {
+  memset(as, 0, sizeof(*as));
+  as->sample_rate = sample_rate;
+  as->freq = 55.0;  // Start at A1
+  as->vol = 0.5;
+  as->mod_index = 3.0;
+  as->mod_ratio = 2.0;  // Harmonic, square-ish tone
+  as->samples_left = 0;
+}
+
+void synth_slap(AudioState* as, double freq) {
+  as->freq = freq;
+  as->phase = 0;  // Reset phase for consistent attack
+  as->mod_phase = 0;
+  as->samples_left = (int)(0.25 * as->sample_rate);
+}
+
+bool synth_render(AudioState* as, int16_t* out, int n) {
+  // Idle voice: one memset instead of writing zeros sample by sample
+  if (as->samples_left <= 0) {
+    memset(out, 0, sizeof(int16_t) * (size_t)n);
+    return false;
+  }
+
+  const double sr = as->sample_rate;
+
+  // Carrier frequency setup
+  double step = (2.0 * M_PI * as->freq) / sr;
+
+  // Modulator setup (the default 2.0 ratio gives a harmonic/square-ish tone)
+  double mod_step = step * as->mod_ratio;
+
+  // ~2.3 ms attack (100 samples at 44.1 kHz)
+  const int attack = (int)(sr / 441.0);
+
+  // Only the part of the block where the note is still sounding
+  int live = n < as->samples_left ? n : as->samples_left;
+  for (int i = 0; i < live; i++) {
+    // 1. Envelope Generator
+    // Simple attack/decay for a percussive "slap bass" feel
+    int tot = (int)(0.25 * sr);
+    int age = tot - as->samples_left;
+    double env = 1.0;
+
+    if (age < attack)
+      env = (double)age / attack;  // Fast attack
+    else
+      env = exp(-15.0 * ((double)(age - attack) / sr));  // Exp decay
+
+    // 2. Advance Phases
+    as->phase += step;
+    as->mod_phase += mod_step;
+
+    // Wrap phases to keep precision happy
+    if (as->phase > 2.0 * M_PI) as->phase -= 2.0 * M_PI;
+    if (as->mod_phase > 2.0 * M_PI) as->mod_phase -= 2.0 * M_PI;
+
+    // 3. FM Synthesis
+    // Modulate the carrier's phase with the modulator's amplitude
+    double modulation = sin(as->mod_phase) * as->mod_index * env;
+    double raw_wave = sin(as->phase + modulation);
+
+    // 4. Hard Clip / Distortion
+    // Keeps it loud and gritty
+    if (raw_wave > 0.8) raw_wave = 0.8;
+    if (raw_wave < -0.8) raw_wave = -0.8;
+
+    // Output 16-bit signed integer
+    out[i] = (int16_t)(raw_wave * 32767.0 * as->vol * env);
+    as->samples_left--;
+  }
+
+  // Silence once the note has finished
+  if (live < n) memset(out + live, 0, sizeof(int16_t) * (size_t)(n - live));
+  return true;
+}
+
+void synth_advance(AudioState* as, int n) {
+  const double sr = as->sample_rate;
+  double step = (2.0 * M_PI * as->freq) / sr;
+  double mod_step = step * as->mod_ratio;
+
+  for (int i = 0; i < n && as->samples_left > 0; i++) {
+    as->phase += step;
+    as->mod_phase += mod_step;
+    if (as->phase > 2.0 * M_PI) as->phase -= 2.0 * M_PI;
+    if (as->mod_phase > 2.0 * M_PI) as->mod_phase -= 2.0 * M_PI;
+    as->samples_left--;
+  }
+}
+
+// Generate frequencies for a Minor Pentatonic scale
+double synth_bass_note(int k) {
+  static const int st[] = {0, 3, 5, 7, 10};
+  int scale_idx = k % 5;
+  int octave = (k / 5) % 2;
+  double base = 55.0 * pow(2.0, octave);
+  return base * pow(2.0, st[scale_idx] / 12.0);
+}
+
+static uint32_t seq_rand(SynthSeq* seq) {
+  uint32_t x = seq->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return seq->rng = x;
+}
+
+void synth_seq_init(SynthSeq* seq, uint32_t seed) {
+  seq->rng = seed ? seed : 1u;  // xorshift gets stuck on 0
+  seq->pos = 0;
+}
+
+void synth_seq_render(AudioState* as, SynthSeq* seq, int16_t* out,
+                      long long n) {
+  const int tick = SYNTH_TICK(as->sample_rate);
+  while (n > 0) {
+    // Same decision the render loop makes on every beat tick
+    if (seq->pos % tick == 0 && seq_rand(seq) % 10 > 2) {
+      synth_slap(as, synth_bass_note((int)(seq_rand(seq) % 15)));
+    }
+
+    // Run up to the next tick so notes land sample-accurately
+    long long run = tick - seq->pos % tick;
+    if (run > n) run = n;
+    if (out) {
+      synth_render(as, out, (int)run);
+      out += run;
+    } else {
+      synth_advance(as, (int)run);
+    }
+    seq->pos += run;
+    n -= run;
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+// --- FUNK ENGINE (SYNTHESIS KERNEL) ---
+// The FM voice that used to live inline in AQCallback. It has no idea what
+// audio device (if any) it is feeding, so the same code runs in the live
+// callback and in the offline benchmark.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Default engine rate. The rate is a runtime setting (see synth_init);
+// this is what the demo, the benchmark and the golden hashes use.
+#define SYNTH_SAMPLE_RATE 44100.0
+
+// Holds the state of our FM synthesizer
+typedef struct {
+  double phase;
+  double freq;
+  double vol;
+  int samples_left;
+  double mod_phase;  // Phase for the FM modulator (the "funk" texture)
+  double mod_index;  // Modulation depth (3.0 by default)
+  double mod_ratio;  // Modulator / carrier frequency (2.0 by default)
+  double sample_rate;
+} AudioState;
+
+void synth_init(AudioState* as, double sample_rate);
+
+// Start a new note: resets the phases and re-arms the envelope.
+void synth_slap(AudioState* as, double freq);
+
+// Render n mono 16-bit samples, writing silence once the note has finished.
+// vol, mod_index and mod_ratio are read once per call, so automation can
+// change them between calls. Returns false (after a plain memset) when the
+// voice was idle for the whole block.
+bool synth_render(AudioState* as, int16_t* out, int n);
+
+// Advance the voice by n samples without producing audio. Uses exactly the
+// same phase/envelope arithmetic as synth_render, so the state it leaves
+// behind matches a real render bit-for-bit (used for offline snapshots).
+void synth_advance(AudioState* as, int n);
+
+// Frequency of step k of the Minor Pentatonic bass scale (two octaves).
+double synth_bass_note(int k);
+
+// --- SEQUENCER ---
+// The render loop's groove (8 ticks/sec, 70% chance of a pentatonic note)
+// driven by the sample clock and a seeded RNG instead of glfwGetTime() and
+// rand(), so a given seed always produces the same performance.
+typedef struct {
+  uint32_t rng;   // xorshift32 state, never 0
+  long long pos;  // Sample clock
+} SynthSeq;
+
+#define SYNTH_TICK(rate) ((int)((rate) / 8.0))
+#define SYNTH_TICK_SAMPLES SYNTH_TICK(SYNTH_SAMPLE_RATE)
+
+void synth_seq_init(SynthSeq* seq, uint32_t seed);
+
+// Play n samples of the sequence into out, triggering notes on tick
+// boundaries (ticks follow as->sample_rate). With out == NULL the state is
+// only advanced (no DSP).
+void synth_seq_render(AudioState* as, SynthSeq* seq, int16_t* out,
+                      long long n);
+
+#endif
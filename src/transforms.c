@@ -0,0 +1,177 @@
+#include "transforms.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+int transforms_init(TransformSet* t, int count) {
+  memset(t, 0, sizeof(*t));
+  if (count < 1) return 0;
+  float* block = (float*)malloc(sizeof(float) * 10 * (size_t)count);
+  if (!block) return 0;
+  t->count = count;
+  float** arrays[10] = {&t->px, &t->py, &t->pz, &t->qx, &t->qy,
+                        &t->qz, &t->qw, &t->sx, &t->sy, &t->sz};
+  for (int a = 0; a < 10; a++) *arrays[a] = block + (size_t)a * count;
+
+  memset(block, 0, sizeof(float) * 7 * (size_t)count);
+  for (int i = 0; i < count; i++) {
+    t->qw[i] = 1.0f;
+    t->sx[i] = t->sy[i] = t->sz[i] = 1.0f;
+  }
+  return 1;
+}
+
+void transforms_free(TransformSet* t) {
+  free(t->px);
+  memset(t, 0, sizeof(*t));
+}
+
+// The rotation part of a unit quaternion, scaled per column:
+//   column 0 = (1 - 2(yy + zz), 2(xy + wz), 2(xz - wy)) * sx
+//   column 1 = (2(xy - wz), 1 - 2(xx + zz), 2(yz + wx)) * sy
+//   column 2 = (2(xz + wy), 2(yz - wx), 1 - 2(xx + yy)) * sz
+static void write_one(const TransformSet* t, int i, float* m) {
+  float x = t->qx[i], y = t->qy[i], z = t->qz[i], w = t->qw[i];
+  float sx = t->sx[i], sy = t->sy[i], sz = t->sz[i];
+  float xx = x * x, yy = y * y, zz = z * z;
+  float xy = x * y, xz = x * z, yz = y * z;
+  float wx = w * x, wy = w * y, wz = w * z;
+
+  m[0] = (1.0f - 2.0f * (yy + zz)) * sx;
+  m[1] = 2.0f * (xy + wz) * sx;
+  m[2] = 2.0f * (xz - wy) * sx;
+  m[3] = 0.0f;
+  m[4] = 2.0f * (xy - wz) * sy;
+  m[5] = (1.0f - 2.0f * (xx + zz)) * sy;
+  m[6] = 2.0f * (yz + wx) * sy;
+  m[7] = 0.0f;
+  m[8] = 2.0f * (xz + wy) * sz;
+  m[9] = 2.0f * (yz - wx) * sz;
+  m[10] = (1.0f - 2.0f * (xx + yy)) * sz;
+  m[11] = 0.0f;
+  m[12] = t->px[i];
+  m[13] = t->py[i];
+  m[14] = t->pz[i];
+  m[15] = 1.0f;
+}
+
+void transforms_write_scalar(const TransformSet* t, int begin, int end,
+                             float* out) {
+  for (int i = begin; i < end; i++) write_one(t, i, out + 16 * (size_t)i);
+}
+
+// Write one column (rows a, b, c, then the constant w) of four consecutive
+// matrices: a 4x4 transpose from element rows to instance columns.
+static inline void store_columns(float* dst, const float* a, const float* b,
+                                 const float* c, float w) {
+#if defined(__SSE__)
+  __m128 r0 = _mm_loadu_ps(a), r1 = _mm_loadu_ps(b), r2 = _mm_loadu_ps(c);
+  __m128 r3 = _mm_set1_ps(w);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(dst, r0);
+  _mm_storeu_ps(dst + 16, r1);
+  _mm_storeu_ps(dst + 32, r2);
+  _mm_storeu_ps(dst + 48, r3);
+#elif defined(__ARM_NEON)
+  float32x4x2_t ab = vzipq_f32(vld1q_f32(a), vld1q_f32(b));
+  float32x4x2_t cw = vzipq_f32(vld1q_f32(c), vdupq_n_f32(w));
+  vst1q_f32(dst, vcombine_f32(vget_low_f32(ab.val[0]),
+                              vget_low_f32(cw.val[0])));
+  vst1q_f32(dst + 16, vcombine_f32(vget_high_f32(ab.val[0]),
+                                   vget_high_f32(cw.val[0])));
+  vst1q_f32(dst + 32, vcombine_f32(vget_low_f32(ab.val[1]),
+                                   vget_low_f32(cw.val[1])));
+  vst1q_f32(dst + 48, vcombine_f32(vget_high_f32(ab.val[1]),
+                                   vget_high_f32(cw.val[1])));
+#else
+  for (int l = 0; l < 4; l++) {
+    dst[16 * l + 0] = a[l];
+    dst[16 * l + 1] = b[l];
+    dst[16 * l + 2] = c[l];
+    dst[16 * l + 3] = w;
+  }
+#endif
+}
+
+// The elements of TRANSFORM_LANES matrices, from a group's rotations
+// (x, y, z, w), scales and positions. Element-major: m[k][l] is element k
+// of matrix l, in column order without the constant last row. Restrict so
+// the lane loop vectorises.
+static inline void group_elements(const float* restrict x,
+                                  const float* restrict y,
+                                  const float* restrict z,
+                                  const float* restrict w,
+                                  const float* restrict sx,
+                                  const float* restrict sy,
+                                  const float* restrict sz,
+                                  const float* restrict px,
+                                  const float* restrict py,
+                                  const float* restrict pz,
+                                  float m[restrict 12][TRANSFORM_LANES]) {
+  for (int l = 0; l < TRANSFORM_LANES; l++) {
+    float xx = x[l] * x[l], yy = y[l] * y[l], zz = z[l] * z[l];
+    float xy = x[l] * y[l], xz = x[l] * z[l], yz = y[l] * z[l];
+    float wx = w[l] * x[l], wy = w[l] * y[l], wz = w[l] * z[l];
+    m[0][l] = (1.0f - 2.0f * (yy + zz)) * sx[l];
+    m[1][l] = 2.0f * (xy + wz) * sx[l];
+    m[2][l] = 2.0f * (xz - wy) * sx[l];
+    m[3][l] = 2.0f * (xy - wz) * sy[l];
+    m[4][l] = (1.0f - 2.0f * (xx + zz)) * sy[l];
+    m[5][l] = 2.0f * (yz + wx) * sy[l];
+    m[6][l] = 2.0f * (xz + wy) * sz[l];
+    m[7][l] = 2.0f * (yz - wx) * sz[l];
+    m[8][l] = (1.0f - 2.0f * (xx + yy)) * sz[l];
+    m[9][l] = px[l];
+    m[10][l] = py[l];
+    m[11][l] = pz[l];
+  }
+}
+
+// Out to one matrix per instance: each column of four instances is a 4x4
+// transpose of element rows, stored 16 bytes at a time, and every 256-byte
+// run is finished before the next starts (kind to a mapped, write-combined
+// buffer)
+static inline void group_store(float m[12][TRANSFORM_LANES], float* dst) {
+  for (int q = 0; q < TRANSFORM_LANES; q += 4, dst += 64) {
+    store_columns(dst + 0, m[0] + q, m[1] + q, m[2] + q, 0.0f);
+    store_columns(dst + 4, m[3] + q, m[4] + q, m[5] + q, 0.0f);
+    store_columns(dst + 8, m[6] + q, m[7] + q, m[8] + q, 0.0f);
+    store_columns(dst + 12, m[9] + q, m[10] + q, m[11] + q, 1.0f);
+  }
+}
+
+void transforms_write(const TransformSet* t, int begin, int end, float* out) {
+  int i = begin;
+  for (; i + TRANSFORM_LANES <= end; i += TRANSFORM_LANES) {
+    float m[12][TRANSFORM_LANES];
+    group_elements(t->qx + i, t->qy + i, t->qz + i, t->qw + i, t->sx + i,
+                   t->sy + i, t->sz + i, t->px + i, t->py + i, t->pz + i, m);
+    group_store(m, out + 16 * (size_t)i);
+  }
+  for (; i < end; i++) write_one(t, i, out + 16 * (size_t)i);
+}
+
+void transforms_write_list(const TransformSet* t, const uint32_t* index,
+                           int n, float* out) {
+  const float* src[10] = {t->qx, t->qy, t->qz, t->qw, t->sx,
+                          t->sy, t->sz, t->px, t->py, t->pz};
+  int k = 0;
+  for (; k + TRANSFORM_LANES <= n; k += TRANSFORM_LANES) {
+    // Gather the group into contiguous lanes, then as above
+    float g[10][TRANSFORM_LANES];
+    for (int a = 0; a < 10; a++) {
+      for (int l = 0; l < TRANSFORM_LANES; l++) g[a][l] = src[a][index[k + l]];
+    }
+    float m[12][TRANSFORM_LANES];
+    group_elements(g[0], g[1], g[2], g[3], g[4], g[5], g[6], g[7], g[8],
+                   g[9], m);
+    group_store(m, out + 16 * (size_t)k);
+  }
+  for (; k < n; k++) write_one(t, (int)index[k], out + 16 * (size_t)k);
+}
@@ -0,0 +1,52 @@
+#ifndef TRANSFORMS_H
+#define TRANSFORMS_H
+
+// --- INSTANCE TRANSFORMS ---
+// Position, rotation and scale for many instances, stored structure-of-
+// arrays, and the kernel that turns them into column-major model matrices
+// (translate * rotate * scale, as glm_translate/glm_rotate/glm_scale would
+// build them). Instances are processed TRANSFORM_LANES at a time: each
+// matrix element is computed for the whole group in one plain loop, which
+// the compiler turns into SSE/AVX/NEON arithmetic, and the group is then
+// written out one matrix after another, straight into whatever the caller
+// points at (e.g. a mapped GL buffer).
+//
+// Ranges are independent, so worker threads can each take a slice.
+
+#include <stdint.h>
+
+#define TRANSFORM_LANES 8  // Matrices per vector group, enough for AVX
+
+typedef struct {
+  int count;
+  float* px;  // Position
+  float* py;
+  float* pz;
+  float* qx;  // Rotation, unit quaternion (x, y, z, w)
+  float* qy;
+  float* qz;
+  float* qw;
+  float* sx;  // Scale
+  float* sy;
+  float* sz;
+} TransformSet;
+
+// `count` instances at the origin, unrotated, unit scale. Returns 0 if the
+// arrays couldn't be allocated.
+int transforms_init(TransformSet* t, int count);
+
+void transforms_free(TransformSet* t);
+
+// Model matrices for instances [begin, end) into out + 16 * begin.
+void transforms_write(const TransformSet* t, int begin, int end, float* out);
+
+// Model matrices for the `n` instances listed in `index` (e.g. the visible
+// ones), packed: instance index[k] goes to out + 16 * k.
+void transforms_write_list(const TransformSet* t, const uint32_t* index,
+                           int n, float* out);
+
+// One instance at a time, for checking and benchmarking the kernel above.
+void transforms_write_scalar(const TransformSet* t, int begin, int end,
+                             float* out);
+
+#endif
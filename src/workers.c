@@ -0,0 +1,97 @@
+#include "workers.h"
+
+#include <string.h>
+
+// Claim chunks until the range is used up
+static void run_chunks(WorkerPool* p) {
+  int begin;
+  while ((begin = atomic_fetch_add(&p->next, p->chunk)) < p->count) {
+    int end = p->count - begin > p->chunk ? begin + p->chunk : p->count;
+    p->fn(p->ctx, begin, end);
+  }
+}
+
+static void* worker_main(void* arg) {
+  WorkerPool* p = (WorkerPool*)arg;
+  // Generation 0 is "no job yet"; a job posted before this thread gets the
+  // lock is still seen, because it bumped the generation past 0
+  unsigned seen = 0;
+  pthread_mutex_lock(&p->lock);
+  for (;;) {
+    while (p->generation == seen && !p->quit) {
+      pthread_cond_wait(&p->wake, &p->lock);
+    }
+    if (p->quit) break;
+    seen = p->generation;
+    pthread_mutex_unlock(&p->lock);
+
+    run_chunks(p);
+
+    pthread_mutex_lock(&p->lock);
+    if (--p->busy == 0) pthread_cond_signal(&p->done);
+  }
+  pthread_mutex_unlock(&p->lock);
+  return NULL;
+}
+
+int workers_start(WorkerPool* p, int threads) {
+  memset(p, 0, sizeof(*p));
+  pthread_mutex_init(&p->lock, NULL);
+  pthread_cond_init(&p->wake, NULL);
+  pthread_cond_init(&p->done, NULL);
+  atomic_init(&p->next, 0);
+  if (threads < 1) threads = 1;
+  if (threads > WORKERS_MAX) threads = WORKERS_MAX;
+
+  p->threads = 1;
+  for (int t = 1; t < threads; t++) {
+    if (pthread_create(&p->tids[t], NULL, worker_main, p) != 0) break;
+    p->threads++;
+  }
+  return p->threads;
+}
+
+void workers_run(WorkerPool* p, int count, int chunk, WorkerFn fn,
+                 void* ctx) {
+  if (count <= 0) return;
+  if (chunk < 1) chunk = 1;
+  // Not worth waking anyone for a single chunk. Still chunk by chunk, so
+  // callers can keep per-chunk results the same way on any thread count.
+  if (p->threads <= 1 || count <= chunk) {
+    for (int begin = 0; begin < count; begin += chunk) {
+      fn(ctx, begin, count - begin > chunk ? begin + chunk : count);
+    }
+    return;
+  }
+
+  pthread_mutex_lock(&p->lock);
+  p->fn = fn;
+  p->ctx = ctx;
+  p->count = count;
+  p->chunk = chunk;
+  atomic_store(&p->next, 0);
+  p->busy = p->threads - 1;
+  p->generation++;
+  pthread_cond_broadcast(&p->wake);
+  pthread_mutex_unlock(&p->lock);
+
+  run_chunks(p);
+
+  // [Concurrency Check] Helpers that woke late still drop `busy`, so the
+  // next job never starts while one of them is reading this one's fields.
+  pthread_mutex_lock(&p->lock);
+  while (p->busy > 0) pthread_cond_wait(&p->done, &p->lock);
+  pthread_mutex_unlock(&p->lock);
+}
+
+void workers_stop(WorkerPool* p) {
+  pthread_mutex_lock(&p->lock);
+  p->quit = true;
+  pthread_cond_broadcast(&p->wake);
+  pthread_mutex_unlock(&p->lock);
+  for (int t = 1; t < p->threads; t++) pthread_join(p->tids[t], NULL);
+  p->threads = 1;
+  pthread_cond_destroy(&p->done);
+  pthread_cond_destroy(&p->wake);
+  pthread_mutex_destroy(&p->lock);
+}
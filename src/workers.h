@@ -0,0 +1,51 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+// --- WORKER POOL ---
+// A fixed set of threads for splitting the render loop's big per-instance
+// loops across cores. workers_run hands the index range out in chunks from
+// an atomic cursor, so a core that falls behind simply takes fewer chunks;
+// the calling thread works too, and the call returns once every chunk is
+// done. Threads sleep on a condition variable between jobs. Nothing here
+// is allocated per job.
+//
+// Not for the audio thread: workers_run blocks.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define WORKERS_MAX 32
+
+// Process [begin, end). Called concurrently for disjoint ranges.
+typedef void (*WorkerFn)(void* ctx, int begin, int end);
+
+typedef struct {
+  int threads;  // Including the caller of workers_run
+  pthread_t tids[WORKERS_MAX];
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  unsigned generation;  // Bumped for every job
+  int busy;             // Helper threads still on the current job
+  bool quit;
+
+  // Current job (written under lock before the generation bump)
+  WorkerFn fn;
+  void* ctx;
+  int count;
+  int chunk;
+  _Atomic int next;  // First index not yet claimed
+} WorkerPool;
+
+// Start threads - 1 helpers (1..WORKERS_MAX). Returns the number of threads
+// actually available, counting the caller; 1 means everything runs inline.
+int workers_start(WorkerPool* p, int threads);
+
+// Run fn over [0, count) in chunks of `chunk` indices. Every call gets one
+// whole chunk, [k * chunk, min((k + 1) * chunk, count)).
+void workers_run(WorkerPool* p, int count, int chunk, WorkerFn fn, void* ctx);
+
+void workers_stop(WorkerPool* p);
+
+#endif
@@ -0,0 +1,205 @@
+// Multi-process check of the network clock sync.
+//
+// With no arguments, leads a timeline on a free localhost port and forks
+// followers whose clocks are deliberately wrong (seconds of offset, tens of
+// ppm of drift). Each follower locks on, then for a few seconds predicts
+// where upcoming beats fall on its own clock. Because every process shares
+// the host's real monotonic clock, the prediction can be mapped back and
+// compared with where the leader actually puts the beat. Exits non-zero if
+// any follower is off by 1 ms or more.
+//
+//   clock_sync [--followers N] [--seconds S]
+//   clock_sync --lead PORT [--seconds S]
+//   clock_sync --follow HOST PORT [--skew-ms X] [--drift-ppm Y] [--seconds S]
+//
+// --lead and --follow run one side each, for trying it across terminals or
+// machines; a follower then just prints its estimate once a second.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "netclock.h"
+
+#define TEMPO 8.0  // Ticks per second, as in the demo
+#define MAX_ERROR_NS 1000000LL
+
+// The follower's simulated clock: true time, offset and running fast/slow
+static long long g_skew_ns;
+static double g_drift;
+static long long g_t0;
+
+static long long skewed_now(void) {
+  long long t = netclock_mono_ns();
+  return t + g_skew_ns + llround(g_drift * (double)(t - g_t0));
+}
+
+// Map a reading of the skewed clock back to true time
+static long long unskew(long long local) {
+  return g_t0 + llround((double)(local - g_skew_ns - g_t0) / (1.0 + g_drift));
+}
+
+static void sleep_ms(long ms) {
+  struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+  nanosleep(&ts, NULL);
+}
+
+// Follow, wait for lock, then measure beat placement against true time.
+// Returns the worst error in ns, or -1 if it never locked.
+static long long follow_and_check(int port, double seconds, bool report) {
+  static NetClock nc;
+  g_t0 = netclock_mono_ns();
+  if (!netclock_follow(&nc, "127.0.0.1", port, skewed_now)) return -1;
+
+  NetClockEstimate e;
+  bool locked = false;
+  for (int i = 0; i < 200 && !locked; i++) {
+    sleep_ms(10);
+    netclock_read(&nc, &e);
+    locked = e.locked;
+  }
+  if (!locked) {
+    netclock_close(&nc);
+    return -1;
+  }
+
+  long long worst = 0;
+  int checks = (int)(seconds * 10.0);
+  for (int i = 0; i < checks; i++) {
+    sleep_ms(100);
+    netclock_read(&nc, &e);
+    // A beat a little ahead, as the sequencer would schedule it
+    long long local_now = skewed_now();
+    long long tick = (long long)floor(netclock_ticks(&e, local_now)) + 2;
+    long long predicted = unskew(netclock_tick_local(&e, tick));
+    long long actual = e.epoch_ns + llround((double)tick * 1e9 / e.tempo);
+    long long err = llabs(predicted - actual);
+    if (err > worst) worst = err;
+  }
+  if (report) {
+    printf("  follower skew %+.1f ms, drift %+.0f ppm: fitted leader drift "
+           "%+.1f ppm, best RTT %.0f us, %d exchanges in fit, worst beat "
+           "error %.1f us\n",
+           g_skew_ns / 1e6, g_drift * 1e6, e.drift * 1e6, e.delay_ns / 1e3,
+           e.exchanges, worst / 1e3);
+  }
+  netclock_close(&nc);
+  return worst;
+}
+
+static int run_check(int followers, double seconds) {
+  static NetClock leader;
+  if (!netclock_lead(&leader, "127.0.0.1", 0, TEMPO)) {
+    printf("Could not bind a localhost UDP port\n");
+    return 1;
+  }
+  printf("Leader on 127.0.0.1:%d, %d followers, %.0f s each\n", leader.port,
+         followers, seconds);
+  fflush(stdout);
+
+  // Spread of skews: big offsets either way, drift well past a real crystal
+  const double skews_ms[] = {3700.0, -1250.0, 0.0, 86400000.0};
+  const double drifts_ppm[] = {40.0, -25.0, 0.0, 100.0};
+  pid_t pids[16];
+  if (followers > 16) followers = 16;
+  for (int f = 0; f < followers; f++) {
+    pids[f] = fork();
+    if (pids[f] == 0) {
+      g_skew_ns = llround(skews_ms[f % 4] * 1e6);
+      g_drift = drifts_ppm[f % 4] * 1e-6;
+      long long worst = follow_and_check(leader.port, seconds, true);
+      fflush(stdout);
+      _exit(worst >= 0 && worst < MAX_ERROR_NS ? 0 : 1);
+    }
+  }
+
+  int failed = 0;
+  for (int f = 0; f < followers; f++) {
+    int status = 0;
+    if (pids[f] < 0 || waitpid(pids[f], &status, 0) < 0 ||
+        !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      failed++;
+  }
+  netclock_close(&leader);
+  if (failed) {
+    printf("FAIL: %d of %d followers missed the 1 ms window\n", failed,
+           followers);
+    return 1;
+  }
+  printf("All %d followers placed beats within 1 ms of the leader\n",
+         followers);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  int followers = 3;
+  double seconds = 4.0;
+  int lead_port = -1;
+  const char* follow_host = NULL;
+  int follow_port = 0;
+  double skew_ms = 0.0, drift_ppm = 0.0;
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--followers") == 0 && a + 1 < argc) {
+      followers = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) {
+      seconds = atof(argv[++a]);
+    } else if (strcmp(argv[a], "--lead") == 0 && a + 1 < argc) {
+      lead_port = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--follow") == 0 && a + 2 < argc) {
+      follow_host = argv[++a];
+      follow_port = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--skew-ms") == 0 && a + 1 < argc) {
+      skew_ms = atof(argv[++a]);
+    } else if (strcmp(argv[a], "--drift-ppm") == 0 && a + 1 < argc) {
+      drift_ppm = atof(argv[++a]);
+    } else {
+      printf("Usage: %s [--followers N] [--seconds S]\n"
+             "       %s --lead PORT [--seconds S]\n"
+             "       %s --follow HOST PORT [--skew-ms X] [--drift-ppm Y] "
+             "[--seconds S]\n",
+             argv[0], argv[0], argv[0]);
+      return 2;
+    }
+  }
+
+  if (lead_port >= 0) {
+    static NetClock nc;
+    if (!netclock_lead(&nc, "0.0.0.0", lead_port, TEMPO)) {
+      printf("Could not bind port %d\n", lead_port);
+      return 1;
+    }
+    printf("Leading on port %d for %.0f s\n", nc.port, seconds);
+    sleep_ms((long)(seconds * 1000.0));
+    netclock_close(&nc);
+    return 0;
+  }
+
+  if (follow_host) {
+    static NetClock nc;
+    g_t0 = netclock_mono_ns();
+    g_skew_ns = llround(skew_ms * 1e6);
+    g_drift = drift_ppm * 1e-6;
+    if (!netclock_follow(&nc, follow_host, follow_port, skewed_now)) {
+      printf("Could not reach %s:%d\n", follow_host, follow_port);
+      return 1;
+    }
+    for (int s = 0; s < (int)seconds; s++) {
+      sleep_ms(1000);
+      NetClockEstimate e;
+      netclock_read(&nc, &e);
+      printf("%s offset %+.3f ms, drift %+.2f ppm, RTT %.0f us, beat %.2f\n",
+             e.locked ? "locked  " : "locking ", e.offset_ns / 1e6,
+             e.drift * 1e6, e.delay_ns / 1e3,
+             e.locked ? netclock_ticks(&e, skewed_now()) : 0.0);
+    }
+    netclock_close(&nc);
+    return 0;
+  }
+
+  return run_check(followers, seconds);
+}
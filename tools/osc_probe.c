@@ -0,0 +1,249 @@
+// OSC loopback check and command-line sender.
+//
+// With no arguments, starts an OSC server on a free localhost port and fires
+// a seeded stream of messages, bundles, unrouted addresses and malformed
+// packets at it from a second socket. A consumer thread drains the event
+// ring once per simulated audio block, like the demo's audio thread does.
+// Every event is checked for order and content, and the latency histogram
+// is printed. Exits non-zero on any mismatch or lost message.
+//
+//   osc_probe [--count N] [--block-us U]
+//   osc_probe --send HOST PORT /address [TYPES ARG...]
+//
+// --send fires one message, e.g. `osc_probe --send 127.0.0.1 9000 /note f
+// 110` plays an A2 slap on a demo started with --osc 9000.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osc.h"
+
+enum { TAG_NOTE = 1, TAG_PARAM = 2 };
+#define PARAM_ID 7
+
+typedef struct {
+  OscQueue queue;
+  int expect;    // Events that should arrive
+  int block_us;  // Drain period
+  int received;
+  int bad;  // Out of order or wrong contents
+  OscLatency latency;
+  atomic_bool done;  // Sender finished
+} Consumer;
+
+static void sleep_us(long us) {
+  struct timespec ts = {us / 1000000, (us % 1000000) * 1000};
+  nanosleep(&ts, NULL);
+}
+
+static void* consumer_main(void* arg) {
+  Consumer* c = (Consumer*)arg;
+  long idle_us = 0;
+  while (c->received < c->expect) {
+    OscEvent ev;
+    bool any = false;
+    long long now = osc_now_ns();
+    while (osc_queue_pop(&c->queue, &ev)) {
+      any = true;
+      osc_latency_note(&c->latency, ev.recv_ns, now);
+      // Notes carry (seq, seq / 2); params carry (seq) on PARAM_ID
+      int seq = (int)ev.v[0];
+      bool ok = seq == c->received &&
+                ((ev.tag == TAG_NOTE && ev.count == 2 &&
+                  ev.v[1] == seq * 0.5f) ||
+                 (ev.tag == TAG_PARAM && ev.count == 1 && ev.id == PARAM_ID));
+      if (!ok) c->bad++;
+      c->received++;
+    }
+    // Give up a second after the sender stops if messages went missing
+    idle_us = any ? 0 : idle_us + c->block_us;
+    if (atomic_load(&c->done) && idle_us > 1000000) break;
+    sleep_us(c->block_us);
+  }
+  return NULL;
+}
+
+// Even sequence numbers are notes, odd ones parameter moves (as an int, so
+// the int-to-float path gets exercised too)
+static int build_seq(char* buf, int cap, int seq) {
+  if (seq % 2 == 0) {
+    return osc_build(buf, cap, "/note", "ff", (double)seq, seq * 0.5);
+  }
+  return osc_build(buf, cap, "/param/depth", "i", seq);
+}
+
+// Wrap n consecutive sequence messages into a #bundle (time tag "now")
+static int build_bundle(char* out, int cap, int first, int n) {
+  if (cap < 16) return 0;
+  memcpy(out, "#bundle", 8);
+  memset(out + 8, 0, 8);
+  out[15] = 1;
+  int off = 16;
+  for (int i = 0; i < n; i++) {
+    if (off + 4 > cap) return 0;
+    int len = build_seq(out + off + 4, cap - off - 4, first + i);
+    if (len == 0) return 0;
+    uint32_t be = htonl((uint32_t)len);
+    memcpy(out + off, &be, 4);
+    off += 4 + len;
+  }
+  return off;
+}
+
+static int send_packet(int fd, const struct sockaddr_in* to, const char* buf,
+                       int len) {
+  return sendto(fd, buf, (size_t)len, 0, (const struct sockaddr*)to,
+                sizeof(*to)) == len;
+}
+
+static int open_client(const char* host, int port, struct sockaddr_in* to) {
+  memset(to, 0, sizeof(*to));
+  to->sin_family = AF_INET;
+  to->sin_port = htons((uint16_t)port);
+  if (inet_pton(AF_INET, host, &to->sin_addr) != 1) return -1;
+  return socket(AF_INET, SOCK_DGRAM, 0);
+}
+
+static int run_send(int argc, char** argv, int a) {
+  if (a + 2 >= argc) {
+    printf("--send needs HOST PORT /address [TYPES ARG...]\n");
+    return 2;
+  }
+  const char* types = a + 3 < argc ? argv[a + 3] : "";
+  int argn = (int)strlen(types);
+  if (argn > OSC_MAX_ARGS || a + 4 + argn != argc) {
+    printf("Need exactly one argument per type tag (at most %d)\n",
+           OSC_MAX_ARGS);
+    return 2;
+  }
+
+  OscArg args[OSC_MAX_ARGS];
+  for (int k = 0; k < argn; k++) {
+    const char* v = argv[a + 4 + k];
+    args[k].type = types[k];
+    if (types[k] == 'i') {
+      args[k].i = atoi(v);
+    } else if (types[k] == 'f') {
+      args[k].f = (float)atof(v);
+    } else if (types[k] == 's') {
+      args[k].s = v;
+    } else {
+      printf("Unsupported type tag '%c' (use i, f or s)\n", types[k]);
+      return 2;
+    }
+  }
+
+  char buf[OSC_PACKET_MAX];
+  int len = osc_build_args(buf, sizeof(buf), argv[a + 2], args, argn);
+  struct sockaddr_in to;
+  int fd = open_client(argv[a], atoi(argv[a + 1]), &to);
+  if (len == 0 || fd < 0) {
+    printf("Could not build or send the message\n");
+    return 1;
+  }
+  int ok = send_packet(fd, &to, buf, len);
+  close(fd);
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  int count = 20000;
+  int block_us = 1000;
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--send") == 0) return run_send(argc, argv, a + 1);
+    if (strcmp(argv[a], "--count") == 0 && a + 1 < argc) {
+      count = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--block-us") == 0 && a + 1 < argc) {
+      block_us = atoi(argv[++a]);
+    } else {
+      printf("Usage: %s [--count N] [--block-us U]\n"
+             "       %s --send HOST PORT /address [TYPES ARG...]\n",
+             argv[0], argv[0]);
+      return 2;
+    }
+  }
+  if (block_us < 1) block_us = 1;
+
+  static OscServer server;
+  static Consumer consumer;
+  if (!osc_open(&server, "127.0.0.1", 0)) {
+    printf("Could not bind a localhost UDP port\n");
+    return 1;
+  }
+  osc_queue_init(&consumer.queue);
+  consumer.expect = count;
+  consumer.block_us = block_us;
+  atomic_init(&consumer.done, false);
+  osc_route(&server, "/note", TAG_NOTE, 0, &consumer.queue);
+  osc_route(&server, "/param/depth", TAG_PARAM, PARAM_ID, &consumer.queue);
+
+  pthread_t cons;
+  if (!osc_start(&server) ||
+      pthread_create(&cons, NULL, consumer_main, &consumer) != 0) {
+    printf("Could not start threads\n");
+    return 1;
+  }
+
+  struct sockaddr_in to;
+  int fd = open_client("127.0.0.1", server.port, &to);
+  if (fd < 0) {
+    printf("Could not open the client socket\n");
+    return 1;
+  }
+
+  // Every tenth packet is a three-message bundle; every hundredth sequence
+  // number also sends an unrouted address and two malformed packets: one
+  // truncated, one whose blob claims nearly 2 GB
+  char buf[OSC_PACKET_MAX];
+  int packets = 0, junk = 0;
+  for (int seq = 0; seq < count;) {
+    int n = 1, len;
+    if (seq % 10 == 0 && seq + 3 <= count) {
+      n = 3;
+      len = build_bundle(buf, sizeof(buf), seq, n);
+    } else {
+      len = build_seq(buf, sizeof(buf), seq);
+    }
+    send_packet(fd, &to, buf, len);
+    if (seq % 100 == 0) {
+      len = osc_build(buf, sizeof(buf), "/nobody", "f", 1.0);
+      send_packet(fd, &to, buf, len);
+      len = osc_build(buf, sizeof(buf), "/note", "ff", 1.0, 2.0);
+      send_packet(fd, &to, buf, len - 4);  // Second float missing
+      static const char blob[] = "/note\0\0\0,bi\0\x7F\xFF\xFF\xFD";
+      send_packet(fd, &to, blob, sizeof(blob) - 1);
+      junk++;
+    }
+    seq += n;
+    // Pace like a busy controller rather than a flood, so the socket
+    // buffer never overflows and any loss is the engine's fault
+    if (++packets % 32 == 0) sleep_us(200);
+  }
+  close(fd);
+  atomic_store(&consumer.done, true);
+  pthread_join(cons, NULL);
+  osc_close(&server);
+  osc_latency_print(&consumer.latency, "receive -> consumer");
+
+  unsigned long long malformed = atomic_load(&server.malformed);
+  unsigned long long unrouted = atomic_load(&server.unrouted);
+  bool pass = consumer.received == count && consumer.bad == 0 &&
+              malformed == 2ull * (unsigned long long)junk &&
+              unrouted == (unsigned long long)junk;
+  if (!pass) {
+    printf("FAIL: %d/%d events (%d bad), %llu/%d malformed, %llu/%d "
+           "unrouted\n",
+           consumer.received, count, consumer.bad, malformed, 2 * junk,
+           unrouted, junk);
+    return 1;
+  }
+  printf("All %d events arrived in order and intact\n", count);
+  return 0;
+}